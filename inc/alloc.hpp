@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+namespace mini {
+	/// <summary>
+	/// Counts the heap allocations of the whole program. The core replaces the global operator new
+	/// and delete in the same file as this class, so the replacements are only linked into programs
+	/// that ask for the counts. Defining MINI_ALLOC_COUNTING_DISABLED leaves the operators alone
+	/// and every count at zero.
+	/// </summary>
+	class allocation_counter final {
+		public:
+			struct counts_t {
+				uint64_t allocations;
+				uint64_t bytes;
+			};
+
+			// whether the operators are replaced and the counts mean anything
+			static bool is_enabled();
+
+			// allocations made by every thread since the program started
+			static counts_t get();
+	};
+
+	/// <summary>
+	/// Allocations made between its construction and the call to get, for timing a phase.
+	/// </summary>
+	class allocation_scope final {
+		private:
+			allocation_counter::counts_t m_start;
+
+		public:
+			inline allocation_scope() : m_start(allocation_counter::get()) { }
+
+			inline allocation_counter::counts_t get() const {
+				auto now = allocation_counter::get();
+				return { now.allocations - m_start.allocations, now.bytes - m_start.bytes };
+			}
+	};
+}
@@ -6,7 +6,10 @@
 #include "parser.hpp"
 #include "millable.hpp"
 #include "cutter.hpp"
+#include "tool.hpp"
+#include "toolpath.hpp"
 #include "curve.hpp"
+#include "memory.hpp"
 
 namespace mini {
 	class application : public app_window {
@@ -22,6 +25,10 @@ namespace mini {
 
 			bool m_grid_enabled;
 			bool m_curve_enabled;
+			bool m_block_quantized;
+
+			// set by complete instantly while the program is still being parsed
+			bool m_complete_instantly;
 
 			float m_milling_speed;
 
@@ -35,9 +42,13 @@ namespace mini {
 			glm::vec3 m_camera_target;
 			offset_t m_vp_mouse_offset;
 
-			// loaded path
+			// loaded path, points keep arriving from the stream until the whole file is parsed
 			std::string m_loaded_path_url;
-			std::vector<glm::vec3> m_path_points;
+			std::shared_ptr<toolpath> m_path;
+			std::unique_ptr<toolpath_stream> m_path_stream;
+
+			// finished stream whose parser thread writes the cache, kept as it waits for the write when destroyed
+			std::unique_ptr<toolpath_stream> m_cache_stream;
 
 			// objects
 			std::shared_ptr<grid_object> m_grid_xz;
@@ -45,6 +56,17 @@ namespace mini {
 			std::shared_ptr<curve> m_curve;
 
 			std::unique_ptr<milling_cutter> m_cutter;
+			std::shared_ptr<milling_cutter_model> m_cutter_model;
+
+			// performance panel, summaries cover the last frames
+			int m_perf_frames;
+			std::vector<float> m_perf_history;
+			std::vector<memory_registry::usage_t> m_memory_usage;
+
+			// carving counters, kept over block restarts
+			bool m_count_writes;
+			bool m_write_overlay;
+			float m_write_overlay_scale;
 
 		public:
 			float get_cam_yaw() const;
@@ -78,9 +100,16 @@ namespace mini {
 			void m_draw_viewport();
 			void m_draw_view_options();
 			void m_draw_milling_options();
+			void m_draw_performance();
+			void m_draw_carving_counters();
+			void m_draw_memory();
 
 			void m_load_path();
+			std::size_t m_take_stream_points();
+			void m_toggle_trace();
 			void m_restart_path();
 			void m_restart_block();
+			void m_make_cutter();
+			void m_refresh_block(const milling_block::carve_stats_t& stats_before);
 	};
 }
\ No newline at end of file
@@ -29,5 +29,6 @@ namespace mini {
 			billboard_object & operator= (const billboard_object &) = delete;
 
 			virtual void render (app_context & context, const glm::mat4x4 & world_matrix) const override;
+			virtual const char * get_name () const override { return "billboard"; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "heightmap.hpp"
+#include "kernel.hpp"
+#include "pyramid.hpp"
+
+namespace mini {
+	// distance between two stamps, relative to the cutter radius
+	constexpr const float MILLING_STEP = 0.025f;
+
+	// masks keep their lowest and highest value over square blocks of 16 texels
+	constexpr const uint32_t MILLING_MASK_BLOCK_SHIFT = 4;
+
+	/// <summary>
+	/// Block of material carved by the cutters, a heightmap with everything needed to carve it
+	/// quickly. Has no rendering of its own and needs no graphics context, millable_block adds
+	/// the texture and the meshes on top of it.
+	/// </summary>
+	class milling_block {
+		public:
+			// footprint of a cutter, texels outside of the spans are never carved
+			struct milling_mask_t {
+				// one span per row, every row has a single run of texels under the cutter
+				std::vector<carve_span_t> spans;
+
+				// height of the cutter surface above its tip relative to the block height,
+				// flat cutters are zero everywhere and leave it empty
+				std::vector<float> profile;
+
+				// the profile rounded to 16 bit heights, only filled in by quantize
+				std::vector<uint16_t> quantized;
+
+				uint32_t width;
+				uint32_t height;
+
+				// bounds of the mask in the units it is carved with, filled in by update_bounds
+				float lowest;
+				uint32_t blocks_x;
+				std::vector<float> block_min;
+				std::vector<float> block_max;
+
+				milling_mask_t(uint32_t width, uint32_t height) : 
+					spans(height, carve_span_t{ 0, 0, 0 }),
+					width(width),
+					height(height),
+					lowest(0.0f),
+					blocks_x(0) { }
+
+				bool is_flat() const;
+
+				void quantize();
+				void update_bounds();
+
+				// bounds of a rectangle of the mask, rounded out to whole blocks. texels outside
+				// of the spans count as infinitely high
+				float get_min(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+				float get_max(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+			};
+
+			struct milling_result_t {
+				bool collision_error;
+				bool depth_error;
+				bool was_milled;
+
+				// texels the carving went over and how many of them it lowered, added to by every
+				// carve the result is passed to. lowered is only counted while writes are counted
+				uint64_t texels;
+				uint64_t lowered;
+
+				milling_result_t() : collision_error(false), depth_error(false), was_milled(false), texels(0), lowered(0) { }
+			};
+
+			// stamps the block was asked to carve and how many of them the height bounds ruled out
+			// before any texel was read. instant carving splits stamps by tile, each part counts.
+			// texels counts the footprint the carving code went over, culled tiles left out, and
+			// lowered the texels that actually got lower, only while writes are counted
+			struct carve_stats_t {
+				uint64_t stamps;
+				uint64_t stamps_culled;
+				uint64_t tiles;
+				uint64_t tiles_culled;
+				uint64_t texels;
+				uint64_t lowered;
+			};
+
+			// carving work done for one path segment, stamps are the operations the cutter issued
+			// whole, however many tiles they were split into
+			struct segment_stats_t {
+				uint64_t stamps;
+				uint64_t texels;
+				uint64_t lowered;
+			};
+
+			// rectangle of heightmap texels, carving restricted to it leaves everything else untouched
+			struct region_t {
+				uint32_t x;
+				uint32_t y;
+				uint32_t width;
+				uint32_t height;
+			};
+
+		private:
+			// only one of the heightmaps is used, depending on the quantization
+			tiled_heightmap m_heightmap;
+			tiled_heightmap16 m_heightmap16;
+
+			// one byte per tile, so workers carving different tiles never share a flag
+			std::vector<uint8_t> m_dirty_tiles;
+
+			// tiles whose maximum in the pyramid is only an upper bound, and per tile counters
+			height_pyramid m_pyramid;
+			std::vector<uint8_t> m_stale_tiles;
+			std::vector<carve_stats_t> m_tile_stats;
+			std::vector<segment_stats_t> m_segment_stats;
+
+			// times every texel was lowered, row-major and only allocated while writes are counted
+			std::vector<uint32_t> m_write_counts;
+			bool m_count_writes;
+
+			uint32_t m_heightmap_width;
+			uint32_t m_heightmap_height;
+
+			uint32_t m_block_width;
+			uint32_t m_block_height;
+
+			glm::vec3 m_block_dimensions;
+			glm::vec3 m_block_translation;
+
+			float m_min_height;
+			bool m_quantized;
+
+		public:
+			uint32_t get_heightmap_width() const;
+			uint32_t get_heightmap_height() const;
+
+			// heightmap tiles along each axis, edge tiles included
+			uint32_t get_tiles_x() const;
+			uint32_t get_tiles_y() const;
+
+			uint32_t get_block_width() const;
+			uint32_t get_block_height() const;
+
+			// whether heights are stored as 16 bit fractions of the block height instead of floats
+			bool is_quantized() const;
+
+			// copies the heightmap into a row-major buffer, with heights relative to the block height
+			void read_heights(std::vector<float>& out) const;
+
+			// the heightmap in use, the other one is empty
+			const tiled_heightmap& get_heightmap() const;
+			const tiled_heightmap16& get_heightmap16() const;
+
+			// tiles carved since the dirty flags were last cleared
+			bool is_tile_dirty(uint32_t tile_x, uint32_t tile_y) const;
+			void clear_dirty_tiles();
+
+			carve_stats_t get_carve_stats() const;
+
+			// clears the tile and segment counters and the write counts
+			void reset_carve_stats();
+
+			// indexed by segment, segments nothing was counted for yet are zero or missing
+			const std::vector<segment_stats_t>& get_segment_stats() const;
+			void add_segment_stats(uint32_t segment, const milling_result_t& result);
+
+			// counting writes goes through scalar carving, which is several times slower than the
+			// vector kernels. only meant for finding out how much of the carving was wasted
+			bool is_counting_writes() const;
+			void set_count_writes(bool count);
+
+			const std::vector<uint32_t>& get_write_counts() const;
+
+			// tightens the bounds of carved tiles and rebuilds the coarse pyramid levels,
+			// must not run while tiles are being carved
+			void update_bounds();
+
+			// errors already set in the result are not checked for again, which saves the work
+			// once a path segment has reported them
+			void carve_silent(
+				const milling_mask_t& mask,
+				int32_t offset_x,
+				int32_t offset_y,
+				float depth,
+				float max_height,
+				milling_result_t& result);
+
+			void carve_silent(
+				const milling_mask_t& mask,
+				int32_t offset_x,
+				int32_t offset_y,
+				float depth,
+				float max_height,
+				const region_t& region,
+				milling_result_t& result);
+
+			// resizes the heightmap and fills it with uncarved material again
+			virtual void set_block_dimensions(uint32_t width, uint32_t height);
+
+			void set_block_size(const glm::vec3 & scale);
+			void set_block_position(const glm::vec3 & position);
+
+			const glm::vec3 & get_block_size() const;
+			const glm::vec3 & get_block_position() const;
+
+			milling_block(uint32_t width, uint32_t height, float min_height, bool quantized = false);
+			virtual ~milling_block();
+
+			milling_block(const milling_block&) = delete;
+			milling_block& operator=(const milling_block&) = delete;
+
+		private:
+			void m_init_heightmap();
+
+			// sends what the heightmap, the bounds and the counters keep to the memory registry
+			void m_report_memory() const;
+
+			void m_mark_dirty(uint32_t x, uint32_t y);
+			void m_mark_stale(uint32_t x, uint32_t y, float min);
+
+			// adds to the counters of the result and returns the kernel flags
+			template <typename T> uint32_t m_carve_tiles(
+				tiled_heightmap_t<T>& heightmap,
+				const milling_mask_t& mask,
+				int32_t offset_x,
+				int32_t offset_y,
+				float depth,
+				float max_height,
+				uint32_t checks,
+				int32_t begin_x,
+				int32_t begin_y,
+				int32_t end_x,
+				int32_t end_y,
+				milling_result_t& result);
+	};
+}
\ No newline at end of file
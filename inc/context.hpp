@@ -8,6 +8,7 @@
 
 #include "shader.hpp"
 #include "camera.hpp"
+#include "timer.hpp"
 
 namespace mini {
 	class app_context;
@@ -41,6 +42,9 @@ namespace mini {
 		public:
 			virtual ~graphics_object () { }
 			virtual void render (app_context & context, const glm::mat4x4 & world_matrix) const = 0;
+
+			// name its draws are timed under on the gpu
+			virtual const char * get_name () const { return "object"; }
 	};
 
 	constexpr const uint64_t RENDER_QUEUE_SIZE = 1024;
@@ -105,6 +109,9 @@ namespace mini {
 			glm::vec3 m_ambient;
 			float m_gamma;
 
+			// not owned, passes are only timed while one is set
+			gpu_timer * m_gpu_timer;
+
 		public:
 			app_context (const video_mode_t & video_mode);
 			~app_context ();
@@ -121,6 +128,7 @@ namespace mini {
 			void clear_post_render ();
 
 			void set_video_mode (const video_mode_t & video_mode);
+			void set_gpu_timer (gpu_timer * timer);
 
 			const video_mode_t & get_video_mode () const;
 			const GLuint get_front_buffer () const;
@@ -145,6 +153,9 @@ namespace mini {
 		private:
 			void m_try_switch_mode ();
 
+			void m_begin_timer (const char * name, uint32_t group);
+			void m_end_timer ();
+
 			void m_init_frame_buffer ();
 			void m_init_screen_quad ();
 
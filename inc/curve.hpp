@@ -6,17 +6,21 @@
 
 #include "shader.hpp"
 #include "context.hpp"
+#include "toolpath.hpp"
 
 namespace mini {
     class curve : public graphics_object {
         private:
-            std::vector<glm::vec3> m_points;
             std::shared_ptr<shader_program> m_line_shader;
 
+            // the points one after another, as they are sent to the gpu
             std::vector<float> m_positions;
             std::vector<uint32_t> m_indices;
             GLuint m_vao, m_position_buffer, m_index_buffer;
 
+            // elements the gpu buffers have room for
+            std::size_t m_position_capacity, m_index_capacity;
+
             bool m_ready;
 
             glm::vec4 m_color;
@@ -32,6 +36,8 @@ namespace mini {
                 const std::vector<glm::vec3>& points
             );
 
+            ~curve();
+
             curve(const curve&) = delete;
             curve& operator=(const curve&) = delete;
 
@@ -45,6 +51,9 @@ namespace mini {
             void prepend_position(const glm::vec3& position);
 
             void append_positions(const std::vector<glm::vec3>& positions);
+
+            // the points of the path from first_point on
+            void append_positions(const toolpath& path, std::size_t first_point);
             void prepend_positions(const std::vector<glm::vec3>& positions);
 
             void erase_tail();
@@ -53,9 +62,14 @@ namespace mini {
             void clear_points();
 
             virtual void render(app_context& context, const glm::mat4x4& world_matrix) const override;
+            virtual const char* get_name() const override { return "path"; }
 
         private:
+            std::size_t m_get_point_count() const;
+
             void m_rebuild_buffers();
+            void m_append_buffers(std::size_t first_point);
             void m_free_buffers();
+            void m_report_memory() const;
     };
 }
\ No newline at end of file
@@ -1,32 +1,60 @@
 #pragma once
-#include "millable.hpp"
-#include "context.hpp"
-#include "mesh.hpp"
+#include <memory>
+#include <vector>
+
+#include "block.hpp"
+#include "toolpath.hpp"
 
 namespace mini {
-	class milling_cutter_model : public graphics_object {
+	// errors a cutter reports, each at most once per path segment
+	constexpr const uint32_t MILLING_ERROR_COLLISION = 1 << 0;
+	constexpr const uint32_t MILLING_ERROR_DEPTH = 1 << 1;
+	constexpr const uint32_t MILLING_ERROR_FLAT = 1 << 2;
+
+	struct milling_error_t {
+		uint32_t type;
+		uint32_t segment;
+	};
+
+	// stamps instant carves between two progress reports. every batch ends waiting for the whole
+	// pool, so it has to spread over enough tiles to keep every thread busy until then
+	constexpr const std::size_t INSTANT_BATCH_STAMPS = 1 << 15;
+
+	class milling_cutter final {
 		private:
-			std::unique_ptr<triangle_mesh> m_mesh;
-			std::shared_ptr<shader_program> m_shader;
+			// a single stamp of the mask
+			struct instant_stamp_t {
+				uint32_t segment;
+				bool vertical;
 
-			float m_blade_height;
+				int32_t offset_x;
+				int32_t offset_y;
+				float depth;
 
-		public:
-			milling_cutter_model(std::shared_ptr<shader_program> shader, float blade_height);
-			~milling_cutter_model();
+				// texels the operation may touch, clipped to the heightmap
+				milling_block::region_t bounds;
+			};
 
-			milling_cutter_model(const milling_cutter_model&) = delete;
-			milling_cutter_model& operator=(const milling_cutter_model&) = delete;
+			// buffers of instant, kept between batches and calls so that carving allocates nothing
+			// once they have grown to the largest batch
+			struct instant_scratch_t {
+				std::vector<instant_stamp_t> stamps;
+				std::vector<milling_block::milling_result_t> stamp_results;
 
-			virtual void render(app_context& context, const glm::mat4x4& world_matrix) const override;
-	};
+				// stamps bucketed by the tiles they touch, the bucket of a tile is the range
+				// [tile_offsets[tile], tile_offsets[tile + 1]) of tile_stamps and tile_results
+				std::vector<uint32_t> tile_offsets;
+				std::vector<uint32_t> tile_stamps;
+				std::vector<milling_block::milling_result_t> tile_results;
+				std::vector<uint32_t> active_tiles;
+			};
 
-	class milling_cutter final {
-		private:
-			std::shared_ptr<milling_cutter_model> m_model;
-			millable_block::milling_mask_t m_mask;
 
-			std::vector<glm::vec3> m_path_points;
+			milling_block::milling_mask_t m_mask;
+
+			// shared with whoever else reads the path, which may keep growing while carving
+			std::shared_ptr<const toolpath> m_path;
+			std::size_t m_path_bytes;
 
 			glm::vec3 m_position;
 			float m_radius;
@@ -35,33 +63,46 @@ namespace mini {
 			float m_interpolation_time;
 			float m_blade_height;
 
-			int m_current_point;
+			std::size_t m_current_point;
 
 			// error flags for path segment
 			bool m_collision_reported;
 			bool m_depth_reported;
 			bool m_flat_reported;
-			
+
+			std::vector<milling_error_t> m_errors;
+			instant_scratch_t m_scratch;
+
 		public:
+			// carves with the cutter the path was read for. update and instant carve the segments the
+			// path has and pick up from there once more points are added to it
 			milling_cutter(
-				std::shared_ptr<shader_program> shader, 
-				std::vector<glm::vec3> path_points,
-				float radius, 
-				bool spherical, 
+				std::shared_ptr<const toolpath> path,
 				float blade_height,
-				const millable_block& block);
+				const milling_block& block);
 
-			~milling_cutter() = default;
+			~milling_cutter();
 
 			float get_radius() const;
 			bool is_spherical() const;
 
-			void update(const float delta_time, millable_block& block);
-			void render(app_context& context);
+			const glm::vec3& get_position() const;
+
+			// every error reported so far, in path order
+			const std::vector<milling_error_t>& get_errors() const;
 
-			void instant(millable_block& block);
+			// moves the cutter along the path and carves, returns whether the block was carved.
+			// the bounds of the block are kept up to date, any texture of it is not
+			bool update(const float delta_time, milling_block& block);
+
+			// carves the rest of the path at once
+			void instant(milling_block& block);
 
 		private:
-			void m_carve(millable_block& block, bool silent, bool vertical);
+			void m_carve(milling_block& block, bool vertical);
+			void m_report(const milling_block::milling_result_t& result, bool vertical);
+			void m_report_memory() const;
+
+			instant_stamp_t m_make_stamp(const milling_block& block, const glm::vec3& position) const;
 	};
 }
\ No newline at end of file
@@ -19,5 +19,6 @@ namespace mini {
 			grid_object & operator= (const grid_object &) = delete;
 
 			virtual void render (app_context & context, const glm::mat4x4 & world_matrix) const override;
+			virtual const char * get_name () const override { return "grid"; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace mini {
+	// side of a square heightmap tile in texels, one tile of floats takes exactly one page
+	constexpr const uint32_t HEIGHTMAP_TILE_SHIFT = 5;
+	constexpr const uint32_t HEIGHTMAP_TILE_SIZE = 1 << HEIGHTMAP_TILE_SHIFT;
+	constexpr const uint32_t HEIGHTMAP_TILE_MASK = HEIGHTMAP_TILE_SIZE - 1;
+	constexpr const uint32_t HEIGHTMAP_TILE_AREA = HEIGHTMAP_TILE_SIZE * HEIGHTMAP_TILE_SIZE;
+
+	/// <summary>
+	/// Heightmap stored as a grid of square tiles, every tile is a contiguous row-major block.
+	/// Edge tiles are padded to the full tile size, the padding is never read by any accessor.
+	/// </summary>
+	template <typename T> class tiled_heightmap_t {
+		private:
+			std::vector<T> m_data;
+
+			uint32_t m_width;
+			uint32_t m_height;
+
+			uint32_t m_tiles_x;
+			uint32_t m_tiles_y;
+
+		public:
+			uint32_t get_width() const;
+			uint32_t get_height() const;
+
+			uint32_t get_tiles_x() const;
+			uint32_t get_tiles_y() const;
+
+			// bytes kept for the texels, padding of the edge tiles included
+			std::size_t get_memory_bytes() const;
+
+			T* get_tile(uint32_t tile_x, uint32_t tile_y);
+			const T* get_tile(uint32_t tile_x, uint32_t tile_y) const;
+
+			inline std::size_t index(uint32_t x, uint32_t y) const {
+				std::size_t tile = (y >> HEIGHTMAP_TILE_SHIFT) * m_tiles_x + (x >> HEIGHTMAP_TILE_SHIFT);
+				return (tile << (2 * HEIGHTMAP_TILE_SHIFT)) +
+					((y & HEIGHTMAP_TILE_MASK) << HEIGHTMAP_TILE_SHIFT) + (x & HEIGHTMAP_TILE_MASK);
+			}
+
+			inline T& at(uint32_t x, uint32_t y) {
+				return m_data[index(x, y)];
+			}
+
+			inline T at(uint32_t x, uint32_t y) const {
+				return m_data[index(x, y)];
+			}
+
+			void resize(uint32_t width, uint32_t height);
+			void fill(T value);
+
+			// copies a rectangle into a row-major buffer of width * height texels
+			void read(uint32_t x, uint32_t y, uint32_t width, uint32_t height, T* out) const;
+			void read(std::vector<T>& out) const;
+
+			// lowest and highest texel of a tile, the padding of edge tiles is left out
+			void get_tile_bounds(uint32_t tile_x, uint32_t tile_y, T& min, T& max) const;
+
+			// calls fn(x, y, width, height, data) for every part of the rectangle that lies in a single
+			// tile, data points at texel (x, y) and its rows are HEIGHTMAP_TILE_SIZE texels apart
+			template <typename F> void for_each_tile(uint32_t x, uint32_t y, uint32_t width, uint32_t height, F&& fn);
+
+			tiled_heightmap_t();
+			tiled_heightmap_t(uint32_t width, uint32_t height);
+	};
+
+	using tiled_heightmap = tiled_heightmap_t<float>;
+	using tiled_heightmap16 = tiled_heightmap_t<uint16_t>;
+
+	// number of steps a 16 bit heightmap splits the block height into. heights are rounded to the
+	// nearest step, so a stored height is off by at most half a step and a carved one by at most
+	// a whole step (block height / 65535, ~3.05 um for the tallest 20 unit block)
+	constexpr const float HEIGHTMAP_QUANTIZATION = 65535.0f;
+
+	template <typename T> struct height_traits;
+
+	template <> struct height_traits<float> {
+		static inline float decode(float value) {
+			return value;
+		}
+
+		static inline float encode(float height) {
+			return height;
+		}
+
+		// carving compares heights in the units the texels are stored in, these convert offsets to
+		// them and back. for 16 bit texels the units are whole steps, which floats hold exactly
+		static inline float to_units(float offset) {
+			return offset;
+		}
+
+		static inline float from_units(float units) {
+			return units;
+		}
+	};
+
+	template <> struct height_traits<uint16_t> {
+		static inline float decode(uint16_t value) {
+			return value / HEIGHTMAP_QUANTIZATION;
+		}
+
+		static inline uint16_t encode(float height) {
+			height = height < 0.0f ? 0.0f : (height > 1.0f ? 1.0f : height);
+			return static_cast<uint16_t>(std::lround(height * HEIGHTMAP_QUANTIZATION));
+		}
+
+		// signed offsets such as carving depths, which may lie outside of the block
+		static inline int32_t encode_offset(float offset) {
+			return static_cast<int32_t>(std::lround(offset * HEIGHTMAP_QUANTIZATION));
+		}
+
+		static inline float to_units(float offset) {
+			return static_cast<float>(encode_offset(offset));
+		}
+
+		static inline float from_units(float units) {
+			return decode(static_cast<uint16_t>(units < 0.0f ? 0.0f : (units > 65535.0f ? 65535.0f : units)));
+		}
+	};
+
+	template <typename T> template <typename F> void tiled_heightmap_t<T>::for_each_tile(
+		uint32_t x, uint32_t y, uint32_t width, uint32_t height, F&& fn) {
+
+		uint32_t end_x = x + width;
+		uint32_t end_y = y + height;
+
+		for (uint32_t ty = y; ty < end_y; ty = (ty | HEIGHTMAP_TILE_MASK) + 1) {
+			uint32_t tile_end_y = (ty | HEIGHTMAP_TILE_MASK) + 1;
+			uint32_t rows = (tile_end_y < end_y ? tile_end_y : end_y) - ty;
+
+			for (uint32_t tx = x; tx < end_x; tx = (tx | HEIGHTMAP_TILE_MASK) + 1) {
+				uint32_t tile_end_x = (tx | HEIGHTMAP_TILE_MASK) + 1;
+				uint32_t cols = (tile_end_x < end_x ? tile_end_x : end_x) - tx;
+
+				fn(tx, ty, cols, rows, m_data.data() + index(tx, ty));
+			}
+		}
+	}
+}
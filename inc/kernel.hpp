@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace mini {
+	// flags reported by the carving kernels, or-ed together over a whole stamp
+	constexpr const uint32_t CARVE_COLLISION = 1 << 0;
+	constexpr const uint32_t CARVE_DEPTH = 1 << 1;
+	constexpr const uint32_t CARVE_MILLED = 1 << 2;
+
+	// the flags that cost work in the kernels, milled is always reported
+	constexpr const uint32_t CARVE_CHECKS = CARVE_COLLISION | CARVE_DEPTH;
+
+	// texels [begin, end) of a mask row lie under the cutter, their profile values are packed
+	// one row after another and the row's values start at offset
+	struct carve_span_t {
+		uint32_t begin;
+		uint32_t end;
+		uint32_t offset;
+	};
+
+	// carves rows of a cutter mask into a block of the heightmap, every texel under a span becomes
+	// min(height, max(mask - depth, 0)). heightmap column 0 lies under mask column x and only the
+	// columns [x, x + width) are carved. kernels for flat cutters ignore the profile, their mask is zero
+	using carve_kernel_t = uint32_t(*)(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height);
+
+	// the same for 16 bit unsigned normalized heights, the scalars are given in the same units.
+	// the arithmetic is done in 32 bits, so values below zero compare exactly like in the float kernels
+	using carve_kernel16_t = uint32_t(*)(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height);
+
+	// scalar carving that also adds one to the write count of every texel it lowers and adds the
+	// number of them to lowered. writes are laid out like the heightmap block with their own stride.
+	// always checks for every error and carves exactly like the selected kernels
+	uint32_t carve_counted(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		bool flat,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered);
+
+	uint32_t carve_counted16(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		bool flat,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered);
+
+	/// <summary>
+	/// Selects the fastest carving kernel supported by the processor the program runs on.
+	/// The selection happens once, the first time the kernel is requested, and can be overridden
+	/// to check the kernels against each other. Every kernel comes in a variant for each cutter
+	/// shape and each combination of checks, so a stamp pays only for the errors that are still
+	/// unreported.
+	/// </summary>
+	class carve_kernel {
+		public:
+			// checks are the CARVE_CHECKS flags the kernel tests for, others never get reported
+			static carve_kernel_t get(bool flat, uint32_t checks);
+			static carve_kernel16_t get16(bool flat, uint32_t checks);
+			static std::string_view get_name();
+
+			// kernels the processor supports, fastest first, scalar is always the last one
+			static std::vector<std::string_view> get_available();
+
+			// switches every later carve to the named kernel, returns false for unknown or
+			// unsupported ones. must not be called while anything is being carved
+			static bool select(std::string_view name);
+
+		private:
+			struct selection_t {
+				// indexed by flat cutter and checks
+				carve_kernel_t kernels[2][4];
+				carve_kernel16_t kernels16[2][4];
+				std::string_view name;
+			};
+
+			static const std::vector<selection_t>& m_available();
+			static const selection_t*& m_current();
+			static const selection_t& m_select();
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace mini {
+	/// <summary>
+	/// Read-only view of a whole file mapped into memory, so it can be scanned in place without
+	/// copying it into buffers first. Empty files open with no data.
+	/// </summary>
+	class mapped_file final {
+		private:
+			const char* m_data;
+			std::size_t m_size;
+			bool m_open;
+
+			// file and mapping handles on windows, the descriptor is closed right after mapping
+			void* m_file;
+			void* m_mapping;
+
+		public:
+			bool is_open() const;
+
+			const char* get_data() const;
+			std::size_t get_size() const;
+
+			// leaves the view closed when the file cannot be opened or mapped
+			mapped_file(const std::string& path);
+			~mapped_file();
+
+			mapped_file(const mapped_file&) = delete;
+			mapped_file& operator=(const mapped_file&) = delete;
+
+		private:
+			void m_close();
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mini {
+	/// <summary>
+	/// Bytes held by the subsystems, every owner reports what it keeps under a subsystem name and
+	/// releases it when it goes away. A report replaces the last one of the same owner and name,
+	/// so owners that are destroyed without releasing keep showing up. Gpu bytes are estimates
+	/// from the sizes and formats of the resources, drivers are free to pad or mirror them.
+	/// </summary>
+	class memory_registry final {
+		public:
+			struct usage_t {
+				const char* name;
+				uint32_t owners;
+				uint64_t host_bytes;
+				uint64_t gpu_bytes;
+			};
+
+		private:
+			struct report_t {
+				const void* owner;
+				const char* name;
+				uint64_t host_bytes;
+				uint64_t gpu_bytes;
+			};
+
+			mutable std::mutex m_mutex;
+			std::vector<report_t> m_reports;
+
+			uint64_t m_host_bytes;
+			uint64_t m_gpu_bytes;
+			uint64_t m_peak_host_bytes;
+			uint64_t m_peak_gpu_bytes;
+
+		public:
+			// name has to outlive the report, subsystems pass string literals
+			void report(const void* owner, const char* name, uint64_t host_bytes, uint64_t gpu_bytes);
+
+			// drops every report of the owner
+			void release(const void* owner);
+
+			// usage summed over the owners of every name, sorted by name
+			void get_usage(std::vector<usage_t>& out) const;
+
+			uint64_t get_host_bytes() const;
+			uint64_t get_gpu_bytes() const;
+
+			// highest totals since the registry was made or the peaks were last reset
+			uint64_t get_peak_host_bytes() const;
+			uint64_t get_peak_gpu_bytes() const;
+			void reset_peak();
+
+			memory_registry();
+
+			memory_registry(const memory_registry&) = delete;
+			memory_registry& operator=(const memory_registry&) = delete;
+
+			static memory_registry& get();
+	};
+
+	// bytes a vector keeps allocated, which is what it costs whatever its size
+	template <typename T> inline uint64_t memory_bytes(const std::vector<T>& vector) {
+		return static_cast<uint64_t>(vector.capacity()) * sizeof(T);
+	}
+}
@@ -1,43 +1,28 @@
 #pragma once
 #include "context.hpp"
+#include "block.hpp"
+#include "upload.hpp"
 
 namespace mini {
-	class millable_block : public graphics_object {
-		public:
-			struct milling_mask_t {
-				std::vector<float> mask;
-
-				uint32_t width;
-				uint32_t height;
-
-				milling_mask_t(uint32_t width, uint32_t height) : 
-					width(width),
-					height(height),
-					mask(width * height) { }
-			};
-
-			struct milling_result_t {
-				bool collision_error;
-				bool depth_error;
-				bool was_milled;
-
-				milling_result_t() : collision_error(false), depth_error(false), was_milled(false) { }
-			};
-
+	// the heightmap texture is updated through a ring of this many staging segments
+	constexpr const std::size_t MILLING_UPLOAD_SEGMENT_SIZE = 1 << 20;
+	constexpr const uint32_t MILLING_UPLOAD_SEGMENTS = 4;
+
+	/// <summary>
+	/// Milling block that can be drawn, keeps a texture of the heightmap and the meshes of the
+	/// top surface and the walls. The texture only catches up with carving in refresh_texture.
+	/// </summary>
+	class millable_block : public milling_block, public graphics_object {
 		private:
-			std::vector<float> m_heightmap;
-
-			uint32_t m_heightmap_width;
-			uint32_t m_heightmap_height;
-
-			uint32_t m_block_width;
-			uint32_t m_block_height;
-
-			glm::vec3 m_block_dimensions;
-			glm::vec3 m_block_translation;
-
 			GLuint m_vao;
 			GLuint m_texture;
+
+			// write counts, made once writes are counted and kept in step with the heightmap texture
+			GLuint m_write_texture;
+			bool m_write_overlay;
+			float m_write_overlay_scale;
+
+			std::unique_ptr<pixel_upload_ring> m_upload_ring;
 			GLuint m_buffer_position, m_buffer_index;
 
 			GLuint m_vao_w;
@@ -53,46 +38,35 @@ namespace mini {
 			std::shared_ptr<shader_program> m_block_shader;
 			std::shared_ptr<shader_program> m_wall_shader;
 
-			float m_min_height;
-
 		public:
-			uint32_t get_heightmap_width() const;
-			uint32_t get_heightmap_height() const;
-
-			uint32_t get_block_width() const;
-			uint32_t get_block_height() const;
-
+			// carves a single stamp and updates the texture right away
 			bool carve(
-				const milling_mask_t& mask, 
-				int32_t offset_x, 
-				int32_t offset_y, 
-				float depth, 
-				float max_height);
-
-			void carve_silent(
 				const milling_mask_t& mask,
 				int32_t offset_x,
 				int32_t offset_y,
 				float depth,
-				float max_height,
-				milling_result_t& result);
+				float max_height);
 
-			void refresh_texture();
+			// sends the tiles carved since the last refresh to the texture, returns the bytes sent
+			std::size_t refresh_texture();
 
-			void set_block_dimensions(uint32_t width, uint32_t height);
+			// colors the top of the block by how many times every texel was lowered, needs writes
+			// to be counted. texels lowered scale times or more show up as the hottest color
+			bool is_write_overlay() const;
+			float get_write_overlay_scale() const;
 
-			void set_block_size(const glm::vec3 & scale);
-			void set_block_position(const glm::vec3 & position);
+			void set_write_overlay(bool overlay);
+			void set_write_overlay_scale(float scale);
 
-			const glm::vec3 & get_block_size() const;
-			const glm::vec3 & get_block_position() const;
+			virtual void set_block_dimensions(uint32_t width, uint32_t height) override;
 
 			millable_block(
-				std::shared_ptr<shader_program> shader, 
+				std::shared_ptr<shader_program> shader,
 				std::shared_ptr<shader_program> wall_shader,
-				uint32_t width, 
+				uint32_t width,
 				uint32_t height,
-				float min_height);
+				float min_height,
+				bool quantized = false);
 
 			~millable_block();
 
@@ -100,11 +74,14 @@ namespace mini {
 			millable_block& operator=(const millable_block&) = delete;
 
 			virtual void render(app_context& context, const glm::mat4x4& world_matrix) const override;
+			virtual const char* get_name() const override { return "block"; }
 
 		private:
 			void m_init_buffers();
 			void m_init_wall_buffers();
+			void m_init_write_texture();
 
 			void m_free_buffers();
+			void m_report_memory() const;
 	};
-}
\ No newline at end of file
+}
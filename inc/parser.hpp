@@ -1,5 +1,7 @@
 #pragma once
 #include <fstream>
+#include <memory>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <optional>
@@ -7,6 +9,8 @@
 #include <unordered_map>
 #include <cstdint>
 
+#include "mapped.hpp"
+
 ///
 /// Example usage
 /// 
@@ -25,40 +29,113 @@
 ///
 
 namespace mini {
+	// programs are parsed in parallel in chunks of at least this many bytes
+	constexpr const std::size_t PARSER_CHUNK_SIZE = 1 << 20;
+
 	struct command_g01_t {
 		float x, y, z;
 	};
 
 	using command_invalid = std::monostate;
 	using milling_command = std::variant<command_g01_t, command_invalid>;
-	using command_parser = std::function<milling_command (const std::string&, std::string::const_iterator&)>;
+	using command_parser = std::function<milling_command (std::string_view, const char*&)>;
+
+	/// <summary>
+	/// Hash of a program fed with its bytes in the order they are read, which the cache of its points
+	/// is checked against. Four words at a time in separate lanes, so checking the program on every
+	/// load costs far less than parsing it.
+	/// </summary>
+	class source_hash final {
+		private:
+			uint64_t m_lanes[4];
+
+			// bytes of the block not yet filled
+			char m_block[32];
+			std::size_t m_buffered;
+
+			uint64_t m_size;
+
+		public:
+			void update(const char* data, std::size_t size);
+
+			// bytes fed so far
+			uint64_t get_size() const;
+			uint64_t get_value() const;
+
+			source_hash();
+	};
 
 	class milling_command_parser {
 		private:
+			struct line_warning_t {
+				int line;
+				std::size_t previous;
+			};
+
+			// commands of a part of the file read on its own. the first line number is only checked
+			// once the chunks before it are known, the warnings are kept until then
+			struct chunk_t {
+				std::vector<milling_command> commands;
+				std::vector<line_warning_t> warnings;
+
+				std::optional<int> first_line;
+				std::optional<std::size_t> last_line;
+
+				// a line that could not be read ends parsing, the chunks after it are dropped
+				bool stopped = false;
+			};
+
 			std::unordered_map<uint64_t, command_parser> m_parsers;
 
+			// the file is scanned in place when it can be mapped, and read line by line otherwise
+			std::unique_ptr<mapped_file> m_mapped;
+			std::size_t m_position;
+
 			std::ifstream m_stream;
 			std::size_t m_previous_line;
 
+			// last line read, reused for every line
+			std::string m_line;
+
+			// of every byte read so far
+			source_hash m_source;
+
 		public:
-			milling_command_parser(const std::string& path);
+			// both modes give the same commands and warnings, mapping the file is several times faster
+			milling_command_parser(const std::string& path, bool mapped = true);
 			~milling_command_parser() = default;
 
 			milling_command_parser(const milling_command_parser&) = delete;
 			milling_command_parser& operator=(const milling_command_parser&) = delete;
 
 			bool is_good() const;
+			bool is_mapped() const;
 
 			std::optional<milling_command> get_next_command();
 			std::vector<milling_command> get_commands();
 
+			// splits the rest of a mapped file between the threads of the shared pool, with the same
+			// commands and warnings as get_commands. small or unmapped files are read one line at a time
+			std::vector<milling_command> get_commands_parallel();
+
+			// hash of the bytes read so far, which are the whole file once no command is left
+			const source_hash& get_source_hash() const;
+
 		private:
-			milling_command m_read_g01_command(const std::string& line, std::string::const_iterator& iter) const;
+			// the line without its line break, valid until the next call
+			bool m_read_line(std::string_view& line);
+
+			// the line number is set once it could be read, even when the command could not
+			std::optional<milling_command> m_parse_line(std::string_view line, std::optional<int>& line_number) const;
+			void m_parse_chunk(const char* data, std::size_t begin, std::size_t end, chunk_t& chunk) const;
+			void m_check_line(int line_number, std::size_t previous) const;
+
+			milling_command m_read_g01_command(std::string_view line, const char*& iter) const;
 
-			char m_peek(const std::string& line, std::string::const_iterator& iter) const;
-			char m_get(const std::string& line, std::string::const_iterator& iter) const;
+			char m_peek(std::string_view line, const char*& iter) const;
+			char m_get(std::string_view line, const char*& iter) const;
 
-			std::optional<int> m_try_read_int(const std::string& line, std::string::const_iterator& iter) const;
-			std::optional<float> m_try_read_float(const std::string & line, std::string::const_iterator & iter) const;
+			std::optional<int> m_try_read_int(std::string_view line, const char*& iter) const;
+			std::optional<float> m_try_read_float(std::string_view line, const char*& iter) const;
 	};
 }
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+
+namespace mini {
+	/// <summary>
+	/// Fixed set of worker threads that run loop iterations in parallel. The thread calling
+	/// parallel_for works as well and only returns once every iteration has finished.
+	/// </summary>
+	class thread_pool final {
+		private:
+			std::vector<std::thread> m_workers;
+
+			std::mutex m_mutex;
+			std::condition_variable m_wake_cv;
+			std::condition_variable m_done_cv;
+
+			const std::function<void(std::size_t)>* m_task;
+			std::size_t m_task_size;
+			std::atomic<std::size_t> m_next_index;
+
+			uint64_t m_generation;
+			uint32_t m_busy_workers;
+			bool m_stop;
+
+		public:
+			// number of threads taking part in a parallel_for, including the caller
+			uint32_t get_thread_count() const;
+
+			// runs fn(i) for every i in [0, count), iterations are handed out one at a time
+			// so uneven iterations balance out, must not be called from inside fn
+			void parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+			thread_pool(uint32_t workers);
+			~thread_pool();
+
+			thread_pool(const thread_pool&) = delete;
+			thread_pool& operator=(const thread_pool&) = delete;
+
+			// shared pool with one thread per hardware thread, unless sized before its first use
+			static thread_pool& get();
+
+			// threads the shared pool is made with, the caller included, zero for one per hardware
+			// thread. returns false once the pool exists, it is never resized
+			static bool set_shared_thread_count(uint32_t threads);
+
+		private:
+			void m_worker_loop(uint32_t index);
+			void m_drain();
+	};
+}
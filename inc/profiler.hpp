@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mini {
+	// number of frames the profiler keeps
+	constexpr const uint32_t PROFILER_HISTORY = 600;
+
+	// series recorded every frame, stages are cpu times in milliseconds, gpu passes are times in
+	// milliseconds a few frames late and the rest are counters
+	constexpr const uint32_t PROFILER_FRAME = 0;
+	constexpr const uint32_t PROFILER_CARVE = 1;
+	constexpr const uint32_t PROFILER_UPLOAD = 2;
+	constexpr const uint32_t PROFILER_DISPLAY = 3;
+	constexpr const uint32_t PROFILER_GUI = 4;
+	constexpr const uint32_t PROFILER_GPU_SCENE = 5;
+	constexpr const uint32_t PROFILER_GPU_RESOLVE = 6;
+	constexpr const uint32_t PROFILER_GPU_GUI = 7;
+	constexpr const uint32_t PROFILER_STAMPS = 8;
+	constexpr const uint32_t PROFILER_TEXELS = 9;
+	constexpr const uint32_t PROFILER_UPLOAD_BYTES = 10;
+	constexpr const uint32_t PROFILER_SERIES = 11;
+
+	/// <summary>
+	/// Rolling history of where the frames went. Stages are timed with begin and end pairs, which
+	/// may come several times a frame, counters add up until the frame ends. Every finished frame
+	/// is pushed into a ring of the last PROFILER_HISTORY frames.
+	/// </summary>
+	class frame_profiler final {
+		public:
+			struct summary_t {
+				float min;
+				float average;
+				float p99;
+			};
+
+		private:
+			// one row of PROFILER_HISTORY frames per series
+			std::vector<float> m_history;
+			std::array<float, PROFILER_SERIES> m_current;
+			std::array<std::chrono::steady_clock::time_point, PROFILER_SERIES> m_started;
+
+			uint32_t m_next;
+			uint32_t m_frames;
+
+		public:
+			static const char* get_series_name(uint32_t series);
+
+			// frames in the history, at most PROFILER_HISTORY
+			uint32_t get_frames() const;
+
+			// copies the last frames of a series into out, oldest first
+			void get_history(uint32_t series, uint32_t frames, std::vector<float>& out) const;
+			summary_t get_summary(uint32_t series, uint32_t frames) const;
+
+			void begin_frame();
+			void end_frame();
+
+			void begin(uint32_t stage);
+			void end(uint32_t stage);
+			void add(uint32_t series, float value);
+
+			frame_profiler();
+	};
+}
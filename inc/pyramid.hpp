@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace mini {
+	/// <summary>
+	/// Coarse minimum and maximum heights of a tiled heightmap. Level 0 holds one node per tile,
+	/// every further level halves the resolution until a single node covers the whole map.
+	/// Carving only ever lowers heights, so a maximum that has not caught up with the texels is
+	/// still a valid upper bound. Only level 0 is kept current while carving, the coarser levels
+	/// catch up in rebuild.
+	/// </summary>
+	class height_pyramid final {
+		private:
+			struct level_t {
+				uint32_t width;
+				uint32_t height;
+
+				std::vector<float> min;
+				std::vector<float> max;
+			};
+
+			std::vector<level_t> m_levels;
+
+		public:
+			uint32_t get_level_count() const;
+
+			// bytes kept for the bounds of every level
+			std::size_t get_memory_bytes() const;
+
+			inline float get_min(uint32_t tile_x, uint32_t tile_y) const {
+				return m_levels[0].min[tile_y * m_levels[0].width + tile_x];
+			}
+
+			inline float get_max(uint32_t tile_x, uint32_t tile_y) const {
+				return m_levels[0].max[tile_y * m_levels[0].width + tile_x];
+			}
+
+			inline void set_bounds(uint32_t tile_x, uint32_t tile_y, float min, float max) {
+				m_levels[0].min[tile_y * m_levels[0].width + tile_x] = min;
+				m_levels[0].max[tile_y * m_levels[0].width + tile_x] = max;
+			}
+
+			inline void lower_min(uint32_t tile_x, uint32_t tile_y, float value) {
+				float& min = m_levels[0].min[tile_y * m_levels[0].width + tile_x];
+				min = value < min ? value : min;
+			}
+
+			// sets every node of every level to the same bounds
+			void reset(uint32_t tiles_x, uint32_t tiles_y, float min, float max);
+
+			// recomputes the coarser levels from level 0
+			void rebuild();
+
+			// upper bound of the heights in the inclusive range of tiles, reads at most four nodes
+			// of the finest level where the range spans no more than two nodes along each axis
+			float query_max(uint32_t tile_begin_x, uint32_t tile_begin_y, uint32_t tile_end_x, uint32_t tile_end_y) const;
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mini {
+	/// <summary>
+	/// Bounded ring of items handed from one producer thread to one consumer thread without locks.
+	/// Each side owns one of the two indices and only reads the other, so neither ever waits on the
+	/// other. The capacity is rounded up to a power of two.
+	/// </summary>
+	template <typename T> class spsc_queue final {
+		private:
+			std::vector<T> m_items;
+			std::size_t m_mask;
+
+			// next item to pop and next slot to push to, on separate cache lines so the two
+			// threads do not keep taking the line from each other
+			alignas(64) std::atomic<std::size_t> m_head;
+			alignas(64) std::atomic<std::size_t> m_tail;
+
+		public:
+			explicit spsc_queue(std::size_t capacity) : m_head(0), m_tail(0) {
+				std::size_t size = 1;
+
+				while (size < capacity) {
+					size <<= 1;
+				}
+
+				m_items.resize(size);
+				m_mask = size - 1;
+			}
+
+			spsc_queue(const spsc_queue&) = delete;
+			spsc_queue& operator=(const spsc_queue&) = delete;
+
+			std::size_t get_capacity() const {
+				return m_items.size();
+			}
+
+			// either side may ask, the answer can be out of date by the time it returns
+			bool is_empty() const {
+				return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+			}
+
+			// producer only, pushes as many of the items as there is room for and returns how many
+			std::size_t try_push(const T* items, std::size_t count) {
+				const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+				const std::size_t head = m_head.load(std::memory_order_acquire);
+				const std::size_t pushed = std::min(count, m_items.size() - (tail - head));
+
+				for (std::size_t i = 0; i < pushed; ++i) {
+					m_items[(tail + i) & m_mask] = items[i];
+				}
+
+				m_tail.store(tail + pushed, std::memory_order_release);
+				return pushed;
+			}
+
+			// consumer only, appends every item pushed so far to out and returns how many there were
+			std::size_t pop_all(std::vector<T>& out) {
+				const std::size_t head = m_head.load(std::memory_order_relaxed);
+				const std::size_t tail = m_tail.load(std::memory_order_acquire);
+
+				for (std::size_t i = head; i != tail; ++i) {
+					out.push_back(m_items[i & m_mask]);
+				}
+
+				m_head.store(tail, std::memory_order_release);
+				return tail - head;
+			}
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace mini {
+	// frames in flight, a frame is read back once the ring comes around to it again
+	constexpr const uint32_t GPU_TIMER_FRAMES = 3;
+
+	// queries per frame, scopes past it are not timed
+	constexpr const uint32_t GPU_TIMER_QUERIES = 128;
+
+	/// <summary>
+	/// Times scopes of gpu work with GL_TIME_ELAPSED queries. Elapsed time queries cannot nest, so
+	/// scopes follow one another and passes are summed up from them by group. Every frame of the
+	/// ring has its own queries and is read back GPU_TIMER_FRAMES - 1 frames later, a frame whose
+	/// results are not ready by then is dropped so the cpu never waits on the gpu.
+	/// </summary>
+	class gpu_timer final {
+		public:
+			struct result_t {
+				const char* name;
+				uint32_t group;
+				float milliseconds;
+			};
+
+		private:
+			struct scope_t {
+				const char* name;
+				uint32_t group;
+			};
+
+			struct frame_t {
+				std::array<GLuint, GPU_TIMER_QUERIES> queries;
+				std::vector<scope_t> scopes;
+			};
+
+			std::array<frame_t, GPU_TIMER_FRAMES> m_frames;
+			uint32_t m_current;
+			bool m_initialized;
+			bool m_running;
+
+			std::vector<result_t> m_results;
+			uint64_t m_dropped;
+
+		public:
+			// scopes of the last frame that was read back, in the order they ran
+			const std::vector<result_t>& get_results() const;
+
+			// frames whose results were not ready in time
+			uint64_t get_dropped_frames() const;
+
+			// moves on to the next frame of the ring, returns whether it brought new results
+			bool begin_frame();
+
+			// name has to outlive the results, scopes pass string literals
+			void begin(const char* name, uint32_t group);
+			void end();
+
+			gpu_timer();
+			~gpu_timer();
+
+			gpu_timer(const gpu_timer&) = delete;
+			gpu_timer& operator=(const gpu_timer&) = delete;
+	};
+}
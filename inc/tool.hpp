@@ -0,0 +1,23 @@
+#pragma once
+#include "context.hpp"
+#include "mesh.hpp"
+
+namespace mini {
+	class milling_cutter_model : public graphics_object {
+		private:
+			std::unique_ptr<triangle_mesh> m_mesh;
+			std::shared_ptr<shader_program> m_shader;
+
+			float m_blade_height;
+
+		public:
+			milling_cutter_model(std::shared_ptr<shader_program> shader, float blade_height);
+			~milling_cutter_model();
+
+			milling_cutter_model(const milling_cutter_model&) = delete;
+			milling_cutter_model& operator=(const milling_cutter_model&) = delete;
+
+			virtual void render(app_context& context, const glm::mat4x4& world_matrix) const override;
+			virtual const char* get_name() const override { return "cutter"; }
+	};
+}
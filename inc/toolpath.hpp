@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "parser.hpp"
+#include "queue.hpp"
+
+namespace mini {
+	// points the parser thread of a stream may be ahead of the one taking them
+	constexpr const std::size_t TOOLPATH_STREAM_CAPACITY = 1 << 16;
+
+	// points the parser thread gathers before handing them over at once
+	constexpr const std::size_t TOOLPATH_STREAM_BATCH = 256;
+
+	/// <summary>
+	/// Cutter path read from a milling program, in scene units. The cutter is named by the file
+	/// extension, .kXX for a ball end and .fXX for a flat end, XX being its diameter in millimetres.
+	/// Coordinates are kept in separate arrays per axis, and every segment between two points
+	/// keeps its length and whether it is vertical, worked out once when the points are added.
+	/// Segment i goes from point i to point i + 1. The cutter, the curve and whatever else reads
+	/// the path share a single toolpath.
+	/// </summary>
+	class toolpath final {
+		private:
+			std::vector<float> m_x;
+			std::vector<float> m_y;
+			std::vector<float> m_z;
+
+			// distance travelled along the path up to every point
+			std::vector<float> m_distances;
+
+			std::vector<float> m_lengths;
+			std::vector<uint8_t> m_vertical;
+
+			float m_radius;
+			bool m_spherical;
+
+		public:
+			float get_radius() const;
+			bool is_spherical() const;
+
+			inline std::size_t get_point_count() const {
+				return m_x.size();
+			}
+
+			inline std::size_t get_segment_count() const {
+				return m_lengths.size();
+			}
+
+			inline glm::vec3 get_point(std::size_t index) const {
+				return { m_x[index], m_y[index], m_z[index] };
+			}
+
+			inline float get_distance(std::size_t index) const {
+				return m_distances[index];
+			}
+
+			inline float get_length(std::size_t segment) const {
+				return m_lengths[segment];
+			}
+
+			inline bool is_vertical(std::size_t segment) const {
+				return m_vertical[segment] != 0;
+			}
+
+			// the box around both ends, read from the points rather than kept for every segment
+			inline void get_segment_bounds(std::size_t segment, glm::vec3& min, glm::vec3& max) const {
+				min = glm::min(get_point(segment), get_point(segment + 1));
+				max = glm::max(get_point(segment), get_point(segment + 1));
+			}
+
+			const std::vector<float>& get_x() const;
+			const std::vector<float>& get_y() const;
+			const std::vector<float>& get_z() const;
+
+			// bounds of every point, zero when there are none
+			void get_bounds(glm::vec3& min, glm::vec3& max) const;
+
+			// bytes kept for the points and the segments
+			std::size_t get_memory_bytes() const;
+
+			void reserve(std::size_t points);
+
+			void push_back(const glm::vec3& point);
+			void append(const std::vector<glm::vec3>& points);
+			void append(const float* x, const float* y, const float* z, std::size_t count);
+
+			void clear();
+
+			toolpath(float radius, bool spherical);
+
+		private:
+			// fills in the segments ending at the points from first_point on
+			void m_update_segments(std::size_t first_point);
+	};
+
+	/// <summary>
+	/// Milling program read on a thread of its own, whose points are handed over while the rest of
+	/// the file is still being parsed, so carving can start right away. The points are the same as
+	/// load_toolpath gives. A single thread takes them, the stream stops its parser when destroyed.
+	/// </summary>
+	class toolpath_stream final {
+		private:
+			spsc_queue<glm::vec3> m_queue;
+			std::thread m_thread;
+
+			// points taken from the queue on their way into a path
+			std::vector<glm::vec3> m_taken;
+
+			std::atomic<bool> m_done;
+			std::atomic<bool> m_stop;
+
+			// path every point was taken into, which the parser thread writes the cache from
+			std::mutex m_cache_mutex;
+			std::condition_variable m_cache_requested;
+			std::shared_ptr<const toolpath> m_cache_points;
+
+			float m_radius;
+			bool m_spherical;
+
+		public:
+			float get_radius() const;
+			bool is_spherical() const;
+
+			// appends the points parsed since the last call to the path, returns how many there were
+			std::size_t take_points(toolpath& path);
+
+			// whether the whole program was parsed and every point taken
+			bool is_finished() const;
+
+			// once finished, has the parser thread write the cache of the program from the path every
+			// point was taken into, which is left as it is meanwhile. destroying the stream waits for it
+			void write_cache(std::shared_ptr<const toolpath> points);
+
+			toolpath_stream(const std::string& path, float radius, bool spherical);
+			~toolpath_stream();
+
+			toolpath_stream(const toolpath_stream&) = delete;
+			toolpath_stream& operator=(const toolpath_stream&) = delete;
+
+		private:
+			void m_parse(std::string path);
+			void m_push(const std::vector<glm::vec3>& points);
+	};
+
+	// reads the cutter from the file extension, returns nothing when it does not name one.
+	// invalid commands are skipped
+	std::shared_ptr<toolpath> load_toolpath(const std::string& path);
+
+	// the same with the cutter given separately, as in k08 or f12
+	std::shared_ptr<toolpath> load_toolpath(const std::string& path, const std::string& cutter);
+
+	// starts parsing in the background, returns nothing when the cutter is invalid
+	std::unique_ptr<toolpath_stream> stream_toolpath(const std::string& path);
+	std::unique_ptr<toolpath_stream> stream_toolpath(const std::string& path, const std::string& cutter);
+
+	// the points of a program are cached in a binary file next to it, named after it with this added
+	constexpr const char* TOOLPATH_CACHE_EXTENSION = ".cache";
+
+	// the points from the cache of the program, nothing when there is none or it no longer matches
+	// the program or the cutter. the cache keeps no warnings, so none are printed
+	std::shared_ptr<toolpath> read_toolpath_cache(const std::string& path);
+	std::shared_ptr<toolpath> read_toolpath_cache(const std::string& path, const std::string& cutter);
+
+	// writes the cache of the program from its points and the hash of the bytes they were parsed
+	// from, returns whether that worked. the cache in place is only replaced once written whole
+	bool write_toolpath_cache(const std::string& path, const toolpath& points, const source_hash& source);
+
+	// load_toolpath through the cache, which is written when it is missing or out of date
+	std::shared_ptr<toolpath> load_toolpath_cached(const std::string& path);
+	std::shared_ptr<toolpath> load_toolpath_cached(const std::string& path, const std::string& cutter);
+}
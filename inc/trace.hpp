@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mini {
+	// events a single thread keeps per capture, the ones past it are dropped and counted
+	constexpr const std::size_t TRACE_BUFFER_EVENTS = 1 << 20;
+
+	// events are kept in chunks of this many, allocated as a thread first needs them
+	constexpr const std::size_t TRACE_CHUNK_EVENTS = 1 << 14;
+
+	/// <summary>
+	/// Records timed zones into a buffer per thread while a capture runs and writes them out in the
+	/// chrome trace_event format, which Perfetto and chrome://tracing open. Recording takes no lock,
+	/// every buffer has a single writer that publishes its size, so captures may be started, stopped
+	/// and written while other threads are recording. Zones that began before the capture started
+	/// are dropped.
+	/// </summary>
+	class trace_recorder final {
+		private:
+			struct event_t {
+				const char* name;
+				uint64_t begin;
+				uint64_t end;
+			};
+
+			// written only by its own thread. the events [0, size) of the capture started at epoch
+			// are complete, a thread that finds a newer capture started empties its buffer itself
+			struct thread_buffer_t {
+				uint32_t id;
+
+				// guarded by the recorder lock
+				std::string name;
+
+				std::atomic<uint64_t> epoch;
+				std::atomic<std::size_t> size;
+				std::atomic<uint64_t> dropped;
+
+				// kept over captures, a chunk is in place before the size covers any of its events
+				std::unique_ptr<event_t[]> chunks[TRACE_BUFFER_EVENTS / TRACE_CHUNK_EVENTS];
+			};
+
+			std::atomic<bool> m_enabled;
+
+			// times are nanoseconds since the recorder was made, the epoch is when the capture started
+			const std::chrono::steady_clock::time_point m_origin;
+			std::atomic<uint64_t> m_epoch;
+
+			// buffers of every thread that ever recorded, they outlive their threads. the lock
+			// guards the list and the names, and keeps start and write apart
+			mutable std::mutex m_mutex;
+			std::vector<std::unique_ptr<thread_buffer_t>> m_buffers;
+
+			// buffer of the calling thread, owned by the recorder
+			static thread_local thread_buffer_t* s_thread_buffer;
+
+		public:
+			inline bool is_enabled() const {
+				return m_enabled.load(std::memory_order_relaxed);
+			}
+
+			// nanoseconds since the recorder was made
+			uint64_t now() const;
+
+			// drops whatever the last capture recorded and starts a new one
+			void start();
+			void stop();
+
+			// writes the last capture as a chrome trace_event json file
+			bool write(const std::string& path) const;
+
+			// name the calling thread shows up under in the trace
+			void set_thread_name(const std::string& name);
+
+			// name has to outlive the capture, zones pass string literals
+			void record(const char* name, uint64_t begin, uint64_t end);
+
+			trace_recorder();
+
+			trace_recorder(const trace_recorder&) = delete;
+			trace_recorder& operator=(const trace_recorder&) = delete;
+
+			static trace_recorder& get();
+
+		private:
+			thread_buffer_t& m_thread_buffer();
+	};
+
+	/// <summary>
+	/// Records the time between its construction and destruction as a zone of the running capture.
+	/// Outside of a capture it costs a single relaxed load.
+	/// </summary>
+	class trace_zone final {
+		private:
+			const char* m_name;
+			uint64_t m_begin;
+			bool m_active;
+
+		public:
+			inline explicit trace_zone(const char* name) : m_name(name), m_begin(0), m_active(false) {
+				auto& recorder = trace_recorder::get();
+
+				if (recorder.is_enabled()) {
+					m_active = true;
+					m_begin = recorder.now();
+				}
+			}
+
+			inline ~trace_zone() {
+				if (m_active) {
+					auto& recorder = trace_recorder::get();
+					recorder.record(m_name, m_begin, recorder.now());
+				}
+			}
+
+			trace_zone(const trace_zone&) = delete;
+			trace_zone& operator=(const trace_zone&) = delete;
+	};
+}
+
+// zones compile to nothing when MINI_TRACE_DISABLED is defined
+#define MINI_TRACE_CONCAT_INNER(a, b) a##b
+#define MINI_TRACE_CONCAT(a, b) MINI_TRACE_CONCAT_INNER(a, b)
+
+#ifdef MINI_TRACE_DISABLED
+#define MINI_TRACE_ZONE(name)
+#else
+#define MINI_TRACE_ZONE(name) ::mini::trace_zone MINI_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#endif
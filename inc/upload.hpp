@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace mini {
+	/// <summary>
+	/// Ring of pixel unpack buffer segments that texture updates are staged through, so the driver
+	/// copies from gpu visible memory asynchronously. A segment is fenced after every flush and is
+	/// reused only once the gpu is done with it, the cpu never waits on a fence. When the next
+	/// segment is still in flight the data is uploaded straight from client memory instead.
+	/// </summary>
+	class pixel_upload_ring final {
+		private:
+			struct segment_t {
+				GLsync fence;
+				std::size_t used;
+			};
+
+			struct pending_t {
+				GLint x, y;
+				GLsizei width, height;
+				GLenum format, type;
+				std::size_t offset;
+			};
+
+			GLuint m_buffer;
+			uint8_t* m_mapped;
+			bool m_persistent;
+
+			std::size_t m_segment_size;
+			std::vector<segment_t> m_segments;
+			uint32_t m_current;
+			bool m_acquired;
+
+			std::vector<pending_t> m_pending;
+
+		public:
+			// whether the buffer is mapped once for its whole lifetime
+			bool is_persistent() const;
+
+			// copies a rectangle of texels into the ring and schedules its upload, rows of the source
+			// are row_stride bytes apart. uploads go to the texture bound to GL_TEXTURE_2D when they
+			// are issued, so it has to stay bound until the next flush
+			void upload(
+				GLint x,
+				GLint y,
+				GLsizei width,
+				GLsizei height,
+				GLenum format,
+				GLenum type,
+				std::size_t texel_size,
+				const void* data,
+				std::size_t row_stride);
+
+			// issues every scheduled upload and fences the segment they were staged in
+			void flush();
+
+			pixel_upload_ring(std::size_t segment_size, uint32_t segment_count);
+			~pixel_upload_ring();
+
+			pixel_upload_ring(const pixel_upload_ring&) = delete;
+			pixel_upload_ring& operator=(const pixel_upload_ring&) = delete;
+
+		private:
+			bool m_acquire();
+			uint8_t* m_segment_data();
+	};
+}
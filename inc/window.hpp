@@ -7,6 +7,9 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "profiler.hpp"
+#include "timer.hpp"
+
 namespace mini {
 	struct offset_t { int x, y; };
 	struct glfw_window_deleter_t {
@@ -31,6 +34,10 @@ namespace mini {
 
 			// delta time calculations
 			std::chrono::steady_clock::time_point m_last_frame;
+			frame_profiler m_profiler;
+
+			// declared after the window so its queries go before the context does
+			gpu_timer m_gpu_timer;
 
 			// user input stuff
 			offset_t m_last_mouse, m_mouse;
@@ -73,6 +80,12 @@ namespace mini {
 			bool is_middle_click () const;
 			bool is_key_down (int key) const;
 
+			frame_profiler & get_profiler ();
+			const frame_profiler & get_profiler () const;
+
+			gpu_timer & get_gpu_timer ();
+			const gpu_timer & get_gpu_timer () const;
+
 			void set_width (uint32_t width);
 			void set_height (uint32_t height);
 			void set_size (uint32_t width, uint32_t height);
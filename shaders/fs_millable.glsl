@@ -1,6 +1,7 @@
 #version 330
 
 uniform sampler2D u_heightmap;
+uniform usampler2D u_writes;
 
 struct point_light_t {
     vec3 color;
@@ -19,6 +20,10 @@ uniform vec3 u_camera_position;
 uniform float u_shininess;
 uniform float u_gamma;
 
+// write count overlay, counts are shown on a log scale that tops out at u_overlay_scale
+uniform bool u_overlay;
+uniform float u_overlay_scale;
+
 in vec3 mv_local_pos;
 in vec3 mv_world_pos;
 
@@ -58,6 +63,11 @@ vec4 phong (point_light_t light, vec3 viewer_direction, vec3 light_direction, ve
     return (diffuse + specular);
 }
 
+// blue through green and yellow to red
+vec3 heat (float t) {
+    return clamp (vec3 (1.5 - abs (4.0 * t - 3.0), 1.5 - abs (4.0 * t - 2.0), 1.5 - abs (4.0 * t - 1.0)), 0.0, 1.0);
+}
+
 vec4 gamma_correct (vec4 color, float gamma) {
     vec4 out_color = color;
     out_color.xyz = pow (out_color.xyz, vec3 (1.0 / gamma));
@@ -124,7 +134,20 @@ void main () {
     // Just visualize the grid lines directly
     float gr_color = 1.0 - min(gr_line, 1.0);
 
-    vec3 final_color = (1.0 - u_surface_color) * gr_color + (1.0 - gr_color) * u_surface_color;
+    vec3 surface_color = u_surface_color;
+
+    if (u_overlay) {
+        ivec2 size = textureSize (u_writes, 0);
+        ivec2 texel = clamp (ivec2 (uv * vec2 (size)), ivec2 (0), size - 1);
+        uint writes = texelFetch (u_writes, texel, 0).r;
+
+        // texels never lowered keep the plain surface
+        if (writes > 0u) {
+            surface_color = heat (clamp (log2 (1.0 + float (writes)) / log2 (1.0 + u_overlay_scale), 0.0, 1.0));
+        }
+    }
+
+    vec3 final_color = (1.0 - surface_color) * gr_color + (1.0 - gr_color) * surface_color;
 
     output_color = gamma_correct (vec4 (u_ambient * final_color, 1.0) + phong_component, u_gamma);
     //output_color = vec4(normal, 1.0);
@@ -1,5 +1,6 @@
 #include "app.hpp"
 #include "gui.hpp"
+#include "trace.hpp"
 
 #include <iostream>
 #include <variant>
@@ -8,6 +9,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <nfd.h>
+#include <implot.h>
 	
 namespace mini {
 	constexpr const std::string_view app_title = "milling simulator";
@@ -48,6 +50,8 @@ namespace mini {
 		app_window(1200, 800, std::string(app_title)),
 		m_context(video_mode_t(1200, 800)) {
 
+		m_context.set_gpu_timer(&get_gpu_timer());
+
 		m_block_min = 1.0f;
 		m_block_size = { 18.0f, 5.0f, 18.0f };
 		m_block_div_x = 1200;
@@ -62,9 +66,15 @@ namespace mini {
 		m_grid_spacing = 1.0f;
 		m_grid_enabled = true;
 		m_curve_enabled = true;
+		m_complete_instantly = false;
+		m_block_quantized = false;
 		m_viewport_focus = false;
 		m_mouse_in_viewport = false;
 		m_last_vp_height = m_last_vp_width = 0;
+		m_perf_frames = 300;
+		m_count_writes = false;
+		m_write_overlay = false;
+		m_write_overlay_scale = 16.0f;
 
 		m_camera_target = { 0.0f, 0.0f, 0.0f };
 
@@ -87,7 +97,8 @@ namespace mini {
 			m_store.get_shader("millable_w"), 
 			m_block_div_x, 
 			m_block_div_y,
-			m_block_min / m_block_size.y);
+			m_block_min / m_block_size.y,
+			m_block_quantized);
 
 		m_block->set_block_size(m_block_size);
 
@@ -141,8 +152,31 @@ namespace mini {
 		m_context.get_camera().set_position(cam_pos);
 		m_context.get_camera().set_target(m_camera_target);
 
-		if (m_cutter) {
-			m_cutter->update(m_milling_speed * delta_time, *m_block.get());
+		std::size_t taken = m_take_stream_points();
+
+		if (m_cutter && m_complete_instantly) {
+			// points the parser read since the last frame are carved at once as well, until it is done
+			if (taken > 0) {
+				const auto stats_before = m_block->get_carve_stats();
+
+				get_profiler().begin(PROFILER_CARVE);
+				m_cutter->instant(*m_block.get());
+				get_profiler().end(PROFILER_CARVE);
+
+				m_refresh_block(stats_before);
+			}
+
+			m_complete_instantly = m_path_stream != nullptr;
+		} else if (m_cutter) {
+			const auto stats_before = m_block->get_carve_stats();
+
+			get_profiler().begin(PROFILER_CARVE);
+			bool carved = m_cutter->update(m_milling_speed * delta_time, *m_block.get());
+			get_profiler().end(PROFILER_CARVE);
+
+			if (carved) {
+				m_refresh_block(stats_before);
+			}
 		}
 
 		app_window::t_integrate(delta_time);
@@ -159,7 +193,12 @@ namespace mini {
 		block_matrix = glm::scale(block_matrix, m_block->get_block_size());
 
 		if (m_cutter) {
-			m_cutter->render(m_context);
+			auto cutter_matrix = glm::mat4x4(1.0f);
+			cutter_matrix = glm::translate(cutter_matrix, m_cutter->get_position());
+			cutter_matrix = glm::scale(cutter_matrix, glm::vec3{ m_cutter->get_radius(), 1.0f, m_cutter->get_radius() });
+			cutter_matrix = glm::rotate(cutter_matrix, 0.5f * glm::pi<float>(), glm::vec3{ 1.0f, 0.0f, 0.0f });
+
+			m_context.draw(m_cutter_model, cutter_matrix);
 		}
 
 		if (m_curve_enabled) {
@@ -167,12 +206,16 @@ namespace mini {
 		}
 
 		m_context.draw(m_block, block_matrix);
+
+		get_profiler().begin(PROFILER_DISPLAY);
 		m_context.display(false, true);
+		get_profiler().end(PROFILER_DISPLAY);
 
 		m_draw_main_window();
 		m_draw_viewport();
 		m_draw_view_options();
 		m_draw_milling_options();
+		m_draw_performance();
 	}
 
 	void application::t_on_character(unsigned int code) {
@@ -263,6 +306,16 @@ namespace mini {
 
 				ImGui::EndMenu();
 			}
+
+			if (ImGui::BeginMenu("Profiling")) {
+				bool capturing = trace_recorder::get().is_enabled();
+
+				if (ImGui::MenuItem(capturing ? "Stop Trace Capture" : "Start Trace Capture", nullptr, nullptr, true)) {
+					m_toggle_trace();
+				}
+
+				ImGui::EndMenu();
+			}
 		}
 
 		ImGui::EndMenuBar();
@@ -310,6 +363,7 @@ namespace mini {
 
 			ImGui::DockBuilderDockWindow("Viewport", dockspace_id);
 			ImGui::DockBuilderDockWindow("View Options", dock_id_left);
+			ImGui::DockBuilderDockWindow("Performance", dock_id_left);
 			ImGui::DockBuilderDockWindow("Milling Options", dock_id_left_bottom);
 
 			ImGui::DockBuilderFinish(dockspace_id);
@@ -413,7 +467,16 @@ namespace mini {
 
 			if (ImGui::Button("Complete Instantly")) {
 				if (m_cutter && m_block) {
+					const auto stats_before = m_block->get_carve_stats();
+
+					get_profiler().begin(PROFILER_CARVE);
 					m_cutter->instant(*m_block.get());
+					get_profiler().end(PROFILER_CARVE);
+
+					m_refresh_block(stats_before);
+
+					// the rest of a program that is still being parsed is carved as it arrives
+					m_complete_instantly = m_path_stream != nullptr;
 				}
 			}
 
@@ -433,6 +496,9 @@ namespace mini {
 
 			gui::vector_editor("Block Dimensions: ", m_block_size);
 
+			gui::prefix_label("16-bit Heights: ", 250.0f);
+			ImGui::Checkbox("##milling_quantized", &m_block_quantized);
+
 			if (ImGui::Button("Apply Settings")) {
 				m_restart_block();
 			}
@@ -454,6 +520,235 @@ namespace mini {
 		ImGui::PopStyleVar(1);
 	}
 
+	void application::m_draw_performance() {
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowMinSize, ImVec2(270, 450));
+		ImGui::Begin("Performance", NULL);
+		ImGui::SetWindowPos(ImVec2(30, 30), ImGuiCond_Once);
+		ImGui::SetWindowSize(ImVec2(270, 450), ImGuiCond_Once);
+
+		const auto& profiler = get_profiler();
+
+		gui::prefix_label("Frames: ", 250.0f);
+		ImGui::InputInt("##perf_frames", &m_perf_frames);
+		gui::clamp(m_perf_frames, 10, static_cast<int>(PROFILER_HISTORY));
+
+		const uint32_t frames = static_cast<uint32_t>(m_perf_frames);
+
+		if (ImGui::CollapsingHeader("Stage Times", ImGuiTreeNodeFlags_DefaultOpen)) {
+			if (ImPlot::BeginPlot("##perf_stages", ImVec2(-1.0f, 200.0f))) {
+				ImPlot::SetupAxes("frame", "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+				for (uint32_t series = PROFILER_FRAME; series <= PROFILER_GUI; ++series) {
+					profiler.get_history(series, frames, m_perf_history);
+					ImPlot::PlotLine(frame_profiler::get_series_name(series), m_perf_history.data(), static_cast<int>(m_perf_history.size()));
+				}
+
+				ImPlot::EndPlot();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("GPU Passes", ImGuiTreeNodeFlags_DefaultOpen)) {
+			if (ImPlot::BeginPlot("##perf_gpu", ImVec2(-1.0f, 200.0f))) {
+				ImPlot::SetupAxes("frame", "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+				for (uint32_t series = PROFILER_GPU_SCENE; series <= PROFILER_GPU_GUI; ++series) {
+					profiler.get_history(series, frames, m_perf_history);
+					ImPlot::PlotLine(frame_profiler::get_series_name(series), m_perf_history.data(), static_cast<int>(m_perf_history.size()));
+				}
+
+				ImPlot::EndPlot();
+			}
+
+			const auto& timer = get_gpu_timer();
+
+			// draws of the last frame read back, they lag GPU_TIMER_FRAMES - 1 frames behind
+			if (ImGui::BeginTable("##perf_gpu_scopes", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+				ImGui::TableSetupColumn("Scope");
+				ImGui::TableSetupColumn("Time");
+				ImGui::TableHeadersRow();
+
+				for (const auto& result : timer.get_results()) {
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(result.name);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f ms", result.milliseconds);
+				}
+
+				ImGui::EndTable();
+			}
+
+			ImGui::Text("Dropped frames: %llu", static_cast<unsigned long long>(timer.get_dropped_frames()));
+		}
+
+		if (ImGui::CollapsingHeader("Summary", ImGuiTreeNodeFlags_DefaultOpen)) {
+			if (ImGui::BeginTable("##perf_summary", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+				ImGui::TableSetupColumn("");
+				ImGui::TableSetupColumn("Min");
+				ImGui::TableSetupColumn("Avg");
+				ImGui::TableSetupColumn("P99");
+				ImGui::TableHeadersRow();
+
+				for (uint32_t series = 0; series < PROFILER_SERIES; ++series) {
+					auto summary = profiler.get_summary(series, frames);
+
+					// stages are in milliseconds, uploads read better in kilobytes
+					const char* format = series <= PROFILER_GPU_GUI ? "%.2f ms" : "%.0f";
+					float scale = 1.0f;
+
+					if (series == PROFILER_UPLOAD_BYTES) {
+						format = "%.1f KiB";
+						scale = 1.0f / 1024.0f;
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(frame_profiler::get_series_name(series));
+					ImGui::TableNextColumn();
+					ImGui::Text(format, summary.min * scale);
+					ImGui::TableNextColumn();
+					ImGui::Text(format, summary.average * scale);
+					ImGui::TableNextColumn();
+					ImGui::Text(format, summary.p99 * scale);
+				}
+
+				ImGui::EndTable();
+			}
+		}
+
+		m_draw_carving_counters();
+		m_draw_memory();
+
+		ImGui::End();
+		ImGui::PopStyleVar(1);
+	}
+
+	void application::m_draw_carving_counters() {
+		if (!ImGui::CollapsingHeader("Carving Counters", ImGuiTreeNodeFlags_DefaultOpen)) {
+			return;
+		}
+
+		gui::prefix_label("Count Writes: ", 250.0f);
+		if (ImGui::Checkbox("##counters_writes", &m_count_writes)) {
+			m_block->set_count_writes(m_count_writes);
+		}
+
+		gui::prefix_label("Overdraw Overlay: ", 250.0f);
+		if (ImGui::Checkbox("##counters_overlay", &m_write_overlay)) {
+			m_block->set_write_overlay(m_write_overlay);
+		}
+
+		gui::prefix_label("Overlay Scale: ", 250.0f);
+		if (ImGui::InputFloat("##counters_scale", &m_write_overlay_scale)) {
+			gui::clamp(m_write_overlay_scale, 1.0f, 1000.0f);
+			m_block->set_write_overlay_scale(m_write_overlay_scale);
+		}
+
+		if (ImGui::Button("Reset Counters")) {
+			m_block->reset_carve_stats();
+			m_block->refresh_texture();
+		}
+
+		const auto& segments = m_block->get_segment_stats();
+		milling_block::segment_stats_t total = { 0, 0, 0 };
+
+		for (const auto& segment : segments) {
+			total.stamps += segment.stamps;
+			total.texels += segment.texels;
+			total.lowered += segment.lowered;
+		}
+
+		// texels visited without getting any lower, only known while writes are counted
+		auto noop_ratio = [](const milling_block::segment_stats_t& stats) {
+			return stats.texels > 0 ? 1.0 - static_cast<double>(stats.lowered) / stats.texels : 0.0;
+		};
+
+		ImGui::Text("Stamps: %llu", static_cast<unsigned long long>(total.stamps));
+		ImGui::Text("Texels Visited: %llu", static_cast<unsigned long long>(total.texels));
+
+		if (m_block->is_counting_writes()) {
+			ImGui::Text("Texels Lowered: %llu", static_cast<unsigned long long>(total.lowered));
+			ImGui::Text("No-op Ratio: %.1f%%", noop_ratio(total) * 100.0);
+		}
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+
+		if (ImGui::BeginTable("##counters_segments", 5, flags, ImVec2(0.0f, 200.0f))) {
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Segment");
+			ImGui::TableSetupColumn("Stamps");
+			ImGui::TableSetupColumn("Texels");
+			ImGui::TableSetupColumn("Lowered");
+			ImGui::TableSetupColumn("No-op");
+			ImGui::TableHeadersRow();
+
+			// programs run into tens of thousands of segments, only the visible rows are drawn
+			ImGuiListClipper clipper;
+			clipper.Begin(static_cast<int>(segments.size()));
+
+			while (clipper.Step()) {
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+					const auto& segment = segments[row];
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::Text("%d", row);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(segment.stamps));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(segment.texels));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(segment.lowered));
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f%%", noop_ratio(segment) * 100.0);
+				}
+			}
+
+			ImGui::EndTable();
+		}
+	}
+
+	void application::m_draw_memory() {
+		if (!ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+			return;
+		}
+
+		constexpr const float mib = 1.0f / (1024.0f * 1024.0f);
+		auto& registry = memory_registry::get();
+
+		ImGui::Text("Host: %.1f MiB (peak %.1f MiB)", registry.get_host_bytes() * mib, registry.get_peak_host_bytes() * mib);
+		ImGui::Text("GPU: %.1f MiB (peak %.1f MiB)", registry.get_gpu_bytes() * mib, registry.get_peak_gpu_bytes() * mib);
+
+		if (ImGui::Button("Reset Peak")) {
+			registry.reset_peak();
+		}
+
+		// more than one owner of the block subsystems means an old block was never released
+		if (ImGui::BeginTable("##memory_usage", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Subsystem");
+			ImGui::TableSetupColumn("Owners");
+			ImGui::TableSetupColumn("Host");
+			ImGui::TableSetupColumn("GPU");
+			ImGui::TableHeadersRow();
+
+			registry.get_usage(m_memory_usage);
+
+			for (const auto& usage : m_memory_usage) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(usage.name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", usage.owners);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f MiB", usage.host_bytes * mib);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f MiB", usage.gpu_bytes * mib);
+			}
+
+			ImGui::EndTable();
+		}
+	}
+
 	void application::m_load_path() {
 		constexpr const nfdchar_t* filters = "";
 		nfdchar_t* in_path = nullptr;
@@ -463,90 +758,116 @@ namespace mini {
 		if (result == NFD_OKAY) {
 			std::string path = std::string(in_path, strlen(in_path));
 
-			if (path.size() < 4) {
-				std::cerr << "invalid file name" << std::endl;
-				return;
-			}
+			// a cache that still matches the program holds every point already, otherwise milling
+			// starts with the first points and the rest arrive while the file is parsed
+			auto cached = read_toolpath_cache(path);
+			std::unique_ptr<toolpath_stream> stream;
 
-			auto ext = path.substr(path.size() - 4);
-			if (ext[0] != '.') {
-				std::cerr << "invalid file name, please use .fXX or .kXX" << std::endl;
-				return;
+			if (!cached) {
+				stream = stream_toolpath(path);
+
+				if (!stream) {
+					return;
+				}
 			}
 
-			bool spherical = false;
-			if (ext[1] == 'f') {
-				spherical = false;
-			} else if (ext[1] == 'k') {
-				spherical = true;
+			m_loaded_path_url = path;
+			set_title(std::string(app_title) + " - " + m_loaded_path_url);
+
+			// the stream of the previous program stops parsing once it is replaced
+			m_path_stream = std::move(stream);
+			m_curve->clear_points();
+
+			// segment counters of the previous program would be mixed up with the new ones
+			m_block->reset_carve_stats();
+
+			if (cached) {
+				std::cout << "[INFO] read " << cached->get_point_count() << " points from the cache of " << path << std::endl;
+				m_path = cached;
 			} else {
-				std::cerr << "invalid cutter name \'" << ext[1] << "\'" << std::endl;
-				return;
+				m_path = std::make_shared<toolpath>(m_path_stream->get_radius(), m_path_stream->is_spherical());
 			}
 
-			int radius = 0;
-			char d0 = ext[2] - '0';
-			char d1 = ext[3] - '0';
+			m_curve->append_positions(*m_path, 0);
+			m_make_cutter();
+			m_take_stream_points();
+		}
+	}
 
-			if (d0 < 0 || d1 < 0 || d0 > 9 || d1 > 9) {
-				std::cerr << "invalid cutter radius \'" << ext[2] << ext[3] << "\'" << std::endl;
-				return;
-			}
+	std::size_t application::m_take_stream_points() {
+		if (!m_path_stream) {
+			return 0;
+		}
 
-			radius = d0 * 10 + d1;
-			std::cout << "loaded cutter data, is sphere: " << spherical << ", radius: " << radius << std::endl;
-			
-			milling_command_parser parser(path);
-			std::vector<milling_command> commands = parser.get_commands();
-			std::vector<glm::vec3> path_points;
-
-			bool parse_error = false;
-
-			for (auto& command : commands) {
-				std::visit([&](const auto& arg) {
-					using T = std::decay_t<decltype(arg)>;
-					if constexpr (std::is_same_v<T, command_invalid>) {
-						std::cerr << "invalid command detected" << std::endl;
-						parse_error = true;
-					} else if constexpr (std::is_same_v<T, command_g01_t>) {
-						path_points.push_back(glm::vec3 { -arg.x, -arg.z, arg.y } * 0.1f);
-					}
-				}, command);
-			}
+		// asked before taking, so no point pushed in between is left behind
+		bool finished = m_path_stream->is_finished();
 
-			m_loaded_path_url = path;
-			set_title(std::string(app_title) + " - " + m_loaded_path_url);
+		// the cutter shares the path, so it picks up the new points on its own
+		std::size_t first = m_path->get_point_count();
+		std::size_t count = m_path_stream->take_points(*m_path);
 
-			m_path_points = path_points;
+		if (count > 0) {
+			m_curve->append_positions(*m_path, first);
+		}
 
-			m_curve->clear_points();
-			m_curve->append_positions(m_path_points);
+		if (finished) {
+			// the next load of the program reads the points straight from the cache, which is written
+			// on the parser thread instead of holding up the frame
+			m_path_stream->write_cache(m_path);
+			m_cache_stream = std::move(m_path_stream);
+		}
 
-			m_cutter = std::make_unique<milling_cutter>(
-				m_store.get_shader("phong"),
-				m_path_points,
-				static_cast<float>(radius) * 0.1f * 0.5f,
-				spherical,
-				m_blade_height,
-				*m_block.get());
+		return count;
+	}
+
+	void application::m_toggle_trace() {
+		auto& recorder = trace_recorder::get();
+
+		if (!recorder.is_enabled()) {
+			std::cout << "[INFO] trace capture started" << std::endl;
+			recorder.start();
+			return;
+		}
+
+		recorder.stop();
+
+		nfdchar_t* out_path = nullptr;
+		nfdresult_t result = NFD_SaveDialog("json", nullptr, &out_path);
+
+		if (result == NFD_OKAY) {
+			recorder.write(std::string(out_path));
+			free(out_path);
 		}
 	}
 
 	void application::m_restart_path() {
-		if (m_cutter && m_path_points.size() > 0) {
-			auto radius = m_cutter->get_radius();
-			auto spherical = m_cutter->is_spherical();
-
-			m_cutter = std::make_unique<milling_cutter>(
-				m_store.get_shader("phong"),
-				m_path_points,
-				radius,
-				spherical,
-				m_blade_height,
-				*m_block.get());
+		if (m_cutter && m_path->get_point_count() > 0) {
+			m_make_cutter();
 		}
 	}
 
+	void application::m_make_cutter() {
+		m_cutter = std::make_unique<milling_cutter>(
+			m_path,
+			m_blade_height,
+			*m_block.get());
+
+		m_complete_instantly = false;
+		m_cutter_model = std::make_shared<milling_cutter_model>(m_store.get_shader("phong"), m_blade_height);
+	}
+
+	void application::m_refresh_block(const milling_block::carve_stats_t& stats_before) {
+		auto& profiler = get_profiler();
+		const auto stats = m_block->get_carve_stats();
+
+		profiler.add(PROFILER_STAMPS, static_cast<float>(stats.stamps - stats_before.stamps));
+		profiler.add(PROFILER_TEXELS, static_cast<float>(stats.texels - stats_before.texels));
+
+		profiler.begin(PROFILER_UPLOAD);
+		profiler.add(PROFILER_UPLOAD_BYTES, static_cast<float>(m_block->refresh_texture()));
+		profiler.end(PROFILER_UPLOAD);
+	}
+
 	void application::m_restart_block() {
 		gui::clamp(m_block_div_x, 500, 1500);
 		gui::clamp(m_block_div_y, 500, 1500);
@@ -563,9 +884,13 @@ namespace mini {
 			m_store.get_shader("millable_w"),
 			m_block_div_x,
 			m_block_div_y,
-			m_block_min / m_block_size.y);
+			m_block_min / m_block_size.y,
+			m_block_quantized);
 
 		m_block->set_block_size(m_block_size);
+		m_block->set_count_writes(m_count_writes);
+		m_block->set_write_overlay(m_write_overlay);
+		m_block->set_write_overlay_scale(m_write_overlay_scale);
 
 		m_restart_path();
 	}
@@ -0,0 +1,860 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "alloc.hpp"
+#include "block.hpp"
+#include "cutter.hpp"
+#include "memory.hpp"
+#include "pool.hpp"
+#include "toolpath.hpp"
+
+// replays the bundled milling programs at several heightmap resolutions and reports how fast the
+// core carves them as json, optionally checked against the report of an earlier run. with --verify
+// it instead checks that every carving kernel and mode leaves the same block as the scalar one,
+// and the scalar one the same as the carving loop the simulator started out with
+
+struct bench_case_t {
+	std::string program;
+	uint32_t resolution;
+
+	uint64_t segments;
+	uint64_t stamps;
+	uint64_t texels;
+
+	// most the block and the cutter kept at once, as reported to the memory registry
+	uint64_t peak_host_bytes;
+
+	// heap allocations made while parsing, while setting up the block and the cutter and while carving
+	uint64_t parse_allocations;
+	uint64_t setup_allocations;
+	uint64_t carve_allocations;
+
+	double parse_time;
+	double carve_time;
+	double wall_time;
+};
+
+struct bench_settings_t {
+	std::string paths;
+	std::vector<std::string> programs;
+	std::vector<uint32_t> resolutions;
+
+	uint32_t repeat;
+	bool quantized;
+
+	// threads carving and parsing, the caller included, zero for one per hardware thread
+	uint32_t threads;
+};
+
+// heightmap and errors a program left, and their hashes for the golden file
+struct verify_run_t {
+	std::vector<float> heights;
+	std::vector<mini::milling_error_t> errors;
+
+	uint64_t heights_hash;
+	uint64_t errors_hash;
+};
+
+// largest differences a run may show against the one it is checked with, in centimeters and cubic
+// centimeters. errors always have to match on every segment
+struct verify_tolerance_t {
+	float max_error;
+	double volume;
+};
+
+struct verify_golden_t {
+	std::string program;
+	uint32_t resolution;
+	std::string mode;
+
+	uint64_t heights_hash;
+	uint64_t errors_hash;
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+// block the programs are carved out of, in centimeters
+static const glm::vec3 bench_block_size = { 18.0f, 5.0f, 18.0f };
+
+// runs that have to match bit for bit
+static const verify_tolerance_t verify_exact = { 0.0f, 0.0 };
+
+static void print_usage() {
+	std::cout <<
+		"usage: millbench [options]\n"
+		"  --paths <dir>           directory with the milling programs, paths by default\n"
+		"  --programs <a,b,...>    programs to replay, 1.k16,2.f12,3.f10,4.k08,5.k01 by default\n"
+		"  --resolutions <a,b,...> heightmap sizes, 500,1200,1500,3000 by default\n"
+		"  --repeat <n>            runs per case, the fastest one is reported, 3 by default\n"
+		"  --quantized             store heights in 16 bits instead of floats\n"
+		"  --threads <n>           threads of the shared pool, the main one included,\n"
+		"                          one per hardware thread by default\n"
+		"  --output <file>         where to write the json report, standard output by default\n"
+		"  --baseline <file>       report of an earlier run to compare the wall times with\n"
+		"  --tolerance <percent>   slowdown against the baseline that counts as a regression,\n"
+		"                          10 by default\n"
+		"  --verify                compare every kernel and carving mode with the scalar kernel,\n"
+		"                          and that with the original carving loop, instead of timing them\n"
+		"  --golden <file>         hashes of the scalar results to check the verification against\n"
+		"  --update-golden         rewrite the golden file with the results of this run\n";
+}
+
+static std::vector<std::string> split_list(const std::string& list) {
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ',')) {
+		if (!item.empty()) {
+			items.push_back(item);
+		}
+	}
+
+	return items;
+}
+
+static double seconds_since(bench_clock::time_point start) {
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// the core logs every batch and every error, which would drown the report
+class mute_output_t {
+	private:
+		std::streambuf* m_out;
+		std::streambuf* m_err;
+
+	public:
+		mute_output_t() : m_out(std::cout.rdbuf(nullptr)), m_err(std::cerr.rdbuf(nullptr)) { }
+
+		~mute_output_t() {
+			std::cout.rdbuf(m_out);
+			std::cerr.rdbuf(m_err);
+			std::cout.clear();
+			std::cerr.clear();
+		}
+};
+
+static bool run_case(const bench_settings_t& settings, bench_case_t& result) {
+	const glm::vec3& size = bench_block_size;
+
+	auto& registry = mini::memory_registry::get();
+
+	for (uint32_t run = 0; run < settings.repeat; ++run) {
+		registry.reset_peak();
+
+		auto start = bench_clock::now();
+		std::shared_ptr<mini::toolpath> toolpath;
+		double parse_time, carve_time;
+		uint64_t parse_allocations, setup_allocations, carve_allocations;
+
+		{
+			mute_output_t mute;
+			mini::allocation_scope allocations;
+			toolpath = mini::load_toolpath(settings.paths + "/" + result.program);
+			parse_time = seconds_since(start);
+			parse_allocations = allocations.get().allocations;
+		}
+
+		if (!toolpath || toolpath->get_point_count() < 2) {
+			std::cerr << "[ERROR] failed to load " << settings.paths << "/" << result.program << std::endl;
+			return false;
+		}
+
+		mini::allocation_scope setup;
+
+		mini::milling_block block(result.resolution, result.resolution, 1.0f / size.y, settings.quantized);
+		block.set_block_size(size);
+
+		mini::milling_cutter cutter(toolpath, 3.0f, block);
+
+		setup_allocations = setup.get().allocations;
+
+		{
+			mute_output_t mute;
+			mini::allocation_scope allocations;
+			auto carve_start = bench_clock::now();
+			cutter.instant(block);
+			carve_time = seconds_since(carve_start);
+			carve_allocations = allocations.get().allocations;
+		}
+
+		double wall_time = seconds_since(start);
+
+		if (run == 0 || wall_time < result.wall_time) {
+			const auto stats = block.get_carve_stats();
+
+			result.segments = toolpath->get_point_count() - 1;
+			result.stamps = stats.stamps;
+			result.texels = stats.texels;
+			result.peak_host_bytes = registry.get_peak_host_bytes();
+			result.parse_allocations = parse_allocations;
+			result.setup_allocations = setup_allocations;
+			result.carve_allocations = carve_allocations;
+			result.parse_time = parse_time;
+			result.carve_time = carve_time;
+			result.wall_time = wall_time;
+		}
+	}
+
+	return true;
+}
+
+static void write_report(
+	std::ostream& out,
+	const bench_settings_t& settings,
+	const std::vector<bench_case_t>& cases,
+	double total_time) {
+
+	// one case per line, so the baseline reader gets away without a json parser
+	out << "{\n";
+	out << "\t\"quantized\": " << (settings.quantized ? "true" : "false") << ",\n";
+	out << "\t\"repeat\": " << settings.repeat << ",\n";
+	out << "\t\"threads\": " << mini::thread_pool::get().get_thread_count() << ",\n";
+	out << "\t\"total_wall_s\": " << total_time << ",\n";
+	out << "\t\"cases\": [\n";
+
+	for (std::size_t i = 0; i < cases.size(); ++i) {
+		const auto& c = cases[i];
+
+		out << "\t\t{ \"program\": \"" << c.program << "\", \"resolution\": " << c.resolution
+			<< ", \"segments\": " << c.segments << ", \"stamps\": " << c.stamps << ", \"texels\": " << c.texels
+			<< ", \"peak_host_bytes\": " << c.peak_host_bytes << ", \"parse_allocations\": " << c.parse_allocations
+			<< ", \"setup_allocations\": " << c.setup_allocations << ", \"carve_allocations\": " << c.carve_allocations
+			<< ", \"parse_s\": " << c.parse_time << ", \"carve_s\": " << c.carve_time << ", \"wall_s\": " << c.wall_time
+			<< ", \"stamps_per_s\": " << c.stamps / c.carve_time << ", \"texels_per_s\": " << c.texels / c.carve_time
+			<< " }" << (i + 1 < cases.size() ? "," : "") << "\n";
+	}
+
+	out << "\t]\n";
+	out << "}\n";
+}
+
+static bool find_value(const std::string& line, const std::string& key, std::string& value) {
+	auto pos = line.find("\"" + key + "\":");
+
+	if (pos == std::string::npos) {
+		return false;
+	}
+
+	pos = line.find_first_not_of(' ', pos + key.size() + 3);
+
+	if (pos == std::string::npos) {
+		return false;
+	}
+
+	if (line[pos] == '"') {
+		auto end = line.find('"', pos + 1);
+		value = line.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+	} else {
+		auto end = line.find_first_of(",}", pos);
+		value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+	}
+
+	return true;
+}
+
+static bool read_baseline(const std::string& path, std::vector<bench_case_t>& cases) {
+	std::ifstream file(path);
+
+	if (!file) {
+		std::cerr << "[ERROR] failed to open baseline " << path << std::endl;
+		return false;
+	}
+
+	std::string line, program, resolution, wall_time;
+
+	while (std::getline(file, line)) {
+		if (!find_value(line, "program", program) ||
+			!find_value(line, "resolution", resolution) ||
+			!find_value(line, "wall_s", wall_time)) {
+			continue;
+		}
+
+		bench_case_t c = {};
+		c.program = program;
+		c.resolution = static_cast<uint32_t>(atoi(resolution.c_str()));
+		c.wall_time = atof(wall_time.c_str());
+
+		cases.push_back(c);
+	}
+
+	return true;
+}
+
+// returns the number of cases that got slower than the tolerance allows
+static uint32_t compare_baseline(
+	const std::vector<bench_case_t>& cases,
+	const std::vector<bench_case_t>& baseline,
+	double tolerance) {
+
+	uint32_t regressions = 0;
+
+	for (const auto& c : cases) {
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&](const bench_case_t& b) {
+			return b.program == c.program && b.resolution == c.resolution;
+		});
+
+		if (it == baseline.end() || it->wall_time <= 0.0) {
+			std::cerr << "[INFO] " << c.program << " at " << c.resolution << " is not in the baseline" << std::endl;
+			continue;
+		}
+
+		double change = (c.wall_time / it->wall_time - 1.0) * 100.0;
+
+		if (change > tolerance) {
+			regressions++;
+			std::cerr << "[WARN] regression on " << c.program << " at " << c.resolution << ": "
+				<< c.wall_time << " s against " << it->wall_time << " s (+" << change << "%)" << std::endl;
+		} else {
+			std::cerr << "[INFO] " << c.program << " at " << c.resolution << ": "
+				<< c.wall_time << " s against " << it->wall_time << " s (" << (change > 0.0 ? "+" : "") << change << "%)" << std::endl;
+		}
+	}
+
+	return regressions;
+}
+
+// fnv-1a, the same on every platform, so the hashes can be kept in the repository
+static uint64_t hash_bytes(const void* data, std::size_t size, uint64_t hash = 14695981039346656037ull) {
+	const auto* bytes = static_cast<const uint8_t*>(data);
+
+	for (std::size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static void verify_carve(
+	const std::shared_ptr<const mini::toolpath>& toolpath,
+	uint32_t resolution,
+	bool quantized,
+	bool count_writes,
+	verify_run_t& run) {
+
+	mini::milling_block block(resolution, resolution, 1.0f / bench_block_size.y, quantized);
+	block.set_block_size(bench_block_size);
+	block.set_count_writes(count_writes);
+
+	mini::milling_cutter cutter(toolpath, 3.0f, block);
+
+	{
+		mute_output_t mute;
+		cutter.instant(block);
+	}
+
+	block.read_heights(run.heights);
+	run.errors = cutter.get_errors();
+
+	run.heights_hash = hash_bytes(run.heights.data(), run.heights.size() * sizeof(float));
+	run.errors_hash = hash_bytes(nullptr, 0);
+
+	for (const auto& error : run.errors) {
+		run.errors_hash = hash_bytes(&error.type, sizeof(error.type), run.errors_hash);
+		run.errors_hash = hash_bytes(&error.segment, sizeof(error.segment), run.errors_hash);
+	}
+}
+
+// the carving loop the simulator started out with, kept apart from the block and the cutter as an
+// oracle for them. every stamp visits the whole rectangle of the mask, with the texels outside of
+// the cutter at the top of the block, and the heightmap is plain floats
+static void verify_oracle(
+	const std::shared_ptr<const mini::toolpath>& toolpath,
+	uint32_t resolution,
+	verify_run_t& run) {
+
+	const float radius = toolpath->get_radius();
+	const bool spherical = toolpath->is_spherical();
+
+	const float unit_size_x = bench_block_size.x / resolution;
+	const float unit_size_y = bench_block_size.z / resolution;
+	const float unit_size_z = 1.0f / bench_block_size.y;
+
+	const float min_height = 1.0f / bench_block_size.y;
+	const float max_height = 3.0f / bench_block_size.y;
+
+	const int32_t mask_width = static_cast<int32_t>(2 * radius / unit_size_x) + 1;
+	const int32_t mask_height = static_cast<int32_t>(2 * radius / unit_size_y) + 1;
+	std::vector<float> mask(static_cast<std::size_t>(mask_width) * mask_height);
+
+	for (int32_t x = 0; x < mask_width; ++x) {
+		for (int32_t y = 0; y < mask_height; ++y) {
+			float dx = x * unit_size_x - radius;
+			float dy = y * unit_size_y - radius;
+			float d = dx * dx + dy * dy;
+
+			if (d <= radius * radius) {
+				mask[y * mask_width + x] = spherical ? (radius - sqrtf(radius * radius - d)) * unit_size_z : 0.0f;
+			} else {
+				mask[y * mask_width + x] = 1.0f;
+			}
+		}
+	}
+
+	auto& heights = run.heights;
+	heights.assign(static_cast<std::size_t>(resolution) * resolution, 1.0f);
+	run.errors.clear();
+
+	const float step = radius * mini::MILLING_STEP;
+
+	for (std::size_t segment = 0; segment + 1 < toolpath->get_point_count(); ++segment) {
+		auto start = toolpath->get_point(segment);
+		auto end = toolpath->get_point(segment + 1);
+		bool vertical = std::abs(start.y - end.y) > 0.0001f;
+
+		bool collision = false, depth_error = false, milled = false;
+
+		auto stamp = [&](const glm::vec3& position) {
+			int32_t offset_x = static_cast<int32_t>((position.x + bench_block_size.x * 0.5f - radius) / unit_size_x);
+			int32_t offset_y = static_cast<int32_t>((position.z + bench_block_size.z * 0.5f - radius) / unit_size_y);
+			float depth = position.y / bench_block_size.y;
+
+			for (int32_t x = std::max(0, -offset_x); x < std::min(mask_width, static_cast<int32_t>(resolution) - offset_x); ++x) {
+				for (int32_t y = std::max(0, -offset_y); y < std::min(mask_height, static_cast<int32_t>(resolution) - offset_y); ++y) {
+					float value = mask[y * mask_width + x] - depth;
+					float& height = heights[static_cast<std::size_t>(y + offset_y) * resolution + x + offset_x];
+
+					if (value + max_height < height) {
+						collision = true;
+					}
+
+					if (value < height) {
+						height = std::max(value, 0.0f);
+						depth_error = depth_error || height < min_height;
+						milled = true;
+					}
+				}
+			}
+		};
+
+		float s = step / glm::distance(start, end);
+		float m = 1.0f;
+
+		while (m > s) {
+			m = m - s;
+			stamp(glm::mix(start, end, glm::min(1.0f, 1.0f - m)));
+		}
+
+		stamp(glm::mix(start, end, 1.0f));
+
+		if (collision) {
+			run.errors.push_back({ mini::MILLING_ERROR_COLLISION, static_cast<uint32_t>(segment) });
+		}
+
+		if (depth_error) {
+			run.errors.push_back({ mini::MILLING_ERROR_DEPTH, static_cast<uint32_t>(segment) });
+		}
+
+		if (milled && vertical && !spherical) {
+			run.errors.push_back({ mini::MILLING_ERROR_FLAT, static_cast<uint32_t>(segment) });
+		}
+	}
+
+	run.heights_hash = hash_bytes(run.heights.data(), run.heights.size() * sizeof(float));
+	run.errors_hash = hash_bytes(nullptr, 0);
+
+	for (const auto& error : run.errors) {
+		run.errors_hash = hash_bytes(&error.type, sizeof(error.type), run.errors_hash);
+		run.errors_hash = hash_bytes(&error.segment, sizeof(error.segment), run.errors_hash);
+	}
+}
+
+// both lists are in path order, returns the number of segments whose errors differ
+static uint32_t compare_errors(
+	const std::vector<mini::milling_error_t>& reference,
+	const std::vector<mini::milling_error_t>& errors,
+	uint32_t& first_segment) {
+
+	uint32_t mismatches = 0;
+	std::size_t i = 0, j = 0;
+
+	while (i < reference.size() || j < errors.size()) {
+		uint32_t segment = std::min(
+			i < reference.size() ? reference[i].segment : UINT32_MAX,
+			j < errors.size() ? errors[j].segment : UINT32_MAX);
+
+		uint32_t reference_types = 0, types = 0;
+
+		for (; i < reference.size() && reference[i].segment == segment; ++i) {
+			reference_types |= reference[i].type;
+		}
+
+		for (; j < errors.size() && errors[j].segment == segment; ++j) {
+			types |= errors[j].type;
+		}
+
+		if (reference_types != types && mismatches++ == 0) {
+			first_segment = segment;
+		}
+	}
+
+	return mismatches;
+}
+
+// compares a run with the reference and logs the differences, returns whether they are within the
+// tolerance. heights are compared in centimeters, the volume is what the run removed beyond what
+// the reference did, in cubic centimeters
+static bool verify_compare(
+	const std::string& name,
+	const verify_run_t& reference,
+	const verify_run_t& run,
+	uint32_t resolution,
+	const verify_tolerance_t& tolerance) {
+
+	float max_error = 0.0f;
+	double volume = 0.0;
+
+	for (std::size_t i = 0; i < reference.heights.size(); ++i) {
+		float difference = reference.heights[i] - run.heights[i];
+		max_error = std::max(max_error, std::abs(difference));
+		volume += difference;
+	}
+
+	max_error *= bench_block_size.y;
+	volume *= bench_block_size.y * (bench_block_size.x / resolution) * (bench_block_size.z / resolution);
+
+	uint32_t first_segment = 0;
+	uint32_t mismatches = compare_errors(reference.errors, run.errors, first_segment);
+
+	// a nan never compares as larger, but it turns the volume into a nan, which fails the gate
+	bool exact = run.heights_hash == reference.heights_hash && mismatches == 0;
+	bool passed = mismatches == 0 && max_error <= tolerance.max_error && std::abs(volume) <= tolerance.volume;
+
+	if (tolerance.max_error == 0.0f && tolerance.volume == 0.0) {
+		passed = exact;
+	}
+
+	std::cerr << (passed ? "[INFO] " : "[WARN] ") << name << ": " << (exact ? "identical" : "differs")
+		<< ", max error " << max_error << " cm, volume " << volume << " cm3, " << run.errors.size() << " errors against "
+		<< reference.errors.size();
+
+	if (!exact) {
+		std::cerr << ", allowed " << tolerance.max_error << " cm and " << tolerance.volume << " cm3";
+	}
+
+	if (mismatches > 0) {
+		std::cerr << ", " << mismatches << " segments differ from segment " << first_segment << " on";
+	}
+
+	std::cerr << std::endl;
+	return passed;
+}
+
+static bool read_golden(const std::string& path, std::vector<verify_golden_t>& golden) {
+	std::ifstream file(path);
+
+	if (!file) {
+		std::cerr << "[ERROR] failed to open golden file " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::stringstream stream(line);
+		verify_golden_t entry;
+
+		if (!(stream >> entry.program >> entry.resolution >> entry.mode >> std::hex >> entry.heights_hash >> entry.errors_hash)) {
+			std::cerr << "[WARN] skipping malformed golden line: " << line << std::endl;
+			continue;
+		}
+
+		golden.push_back(entry);
+	}
+
+	return true;
+}
+
+static bool write_golden(const std::string& path, const std::vector<verify_golden_t>& golden) {
+	std::ofstream file(path);
+
+	file << "# program resolution mode heights_hash errors_hash, written by millbench --update-golden\n";
+
+	for (const auto& entry : golden) {
+		char hashes[40];
+		snprintf(hashes, sizeof(hashes), "%016" PRIx64 " %016" PRIx64, entry.heights_hash, entry.errors_hash);
+		file << entry.program << " " << entry.resolution << " " << entry.mode << " " << hashes << "\n";
+	}
+
+	if (!file) {
+		std::cerr << "[ERROR] failed to write golden file " << path << std::endl;
+		return false;
+	}
+
+	std::cerr << "[INFO] wrote " << golden.size() << " golden hashes to " << path << std::endl;
+	return true;
+}
+
+// returns whether the run hashes to what the golden file holds for it, runs missing from it pass
+static bool check_golden(
+	const std::vector<verify_golden_t>& golden,
+	const verify_golden_t& entry) {
+
+	auto it = std::find_if(golden.begin(), golden.end(), [&](const verify_golden_t& g) {
+		return g.program == entry.program && g.resolution == entry.resolution && g.mode == entry.mode;
+	});
+
+	if (it == golden.end()) {
+		std::cerr << "[INFO] " << entry.program << " at " << entry.resolution << " " << entry.mode << " is not in the golden file" << std::endl;
+		return true;
+	}
+
+	if (it->heights_hash != entry.heights_hash || it->errors_hash != entry.errors_hash) {
+		std::cerr << "[WARN] " << entry.program << " at " << entry.resolution << " " << entry.mode << " does not match the golden file, "
+			<< (it->heights_hash != entry.heights_hash ? "heights" : "errors") << " changed" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// returns the number of failed comparisons, or -1 when a program could not be loaded
+static int verify(
+	const bench_settings_t& settings,
+	const std::vector<verify_golden_t>& golden,
+	std::vector<verify_golden_t>& results) {
+
+	const auto kernels = mini::carve_kernel::get_available();
+	const std::string_view fastest = kernels.front();
+	int failures = 0;
+
+	for (const auto& program : settings.programs) {
+		std::shared_ptr<mini::toolpath> toolpath;
+
+		{
+			mute_output_t mute;
+			toolpath = mini::load_toolpath(settings.paths + "/" + program);
+		}
+
+		if (!toolpath || toolpath->get_point_count() < 2) {
+			std::cerr << "[ERROR] failed to load " << settings.paths << "/" << program << std::endl;
+			return -1;
+		}
+
+		for (uint32_t resolution : settings.resolutions) {
+			verify_run_t oracle;
+			verify_oracle(toolpath, resolution, oracle);
+
+			for (bool quantized : { false, true }) {
+				const std::string storage = quantized ? "quantized" : "float";
+				const std::string prefix = program + " at " + std::to_string(resolution) + " " + storage + " ";
+
+				// the scalar kernel is the reference, checked against the oracle first. 16 bit heights
+				// round the mask and the depth of every stamp to the nearest step, which leaves every
+				// height within a step of the float one, give or take the rounding of the float heights
+				verify_run_t reference, run;
+				mini::carve_kernel::select("scalar");
+				verify_carve(toolpath, resolution, quantized, false, reference);
+
+				verify_tolerance_t oracle_tolerance = verify_exact;
+
+				if (quantized) {
+					oracle_tolerance.max_error = 1.01f * bench_block_size.y / mini::HEIGHTMAP_QUANTIZATION;
+					oracle_tolerance.volume = oracle_tolerance.max_error * bench_block_size.x * bench_block_size.z;
+				}
+
+				failures += !verify_compare(prefix + "oracle", oracle, reference, resolution, oracle_tolerance);
+
+				verify_golden_t entry = { program, resolution, storage + "/scalar", reference.heights_hash, reference.errors_hash };
+				failures += !check_golden(golden, entry);
+				results.push_back(entry);
+
+				// counting writes takes the scalar path of its own
+				verify_carve(toolpath, resolution, quantized, true, run);
+				failures += !verify_compare(prefix + "counted", reference, run, resolution, verify_exact);
+
+				for (const auto& kernel : kernels) {
+					if (kernel == "scalar") {
+						continue;
+					}
+
+					mini::carve_kernel::select(kernel);
+					verify_carve(toolpath, resolution, quantized, false, run);
+					failures += !verify_compare(prefix + std::string(kernel), reference, run, resolution, verify_exact);
+				}
+			}
+		}
+	}
+
+	mini::carve_kernel::select(fastest);
+	return failures;
+}
+
+int main(int argc, char** argv) {
+	bench_settings_t settings = {
+		"paths",
+		{ "1.k16", "2.f12", "3.f10", "4.k08", "5.k01" },
+		{ 500, 1200, 1500, 3000 },
+		3,
+		false,
+		0
+	};
+
+	std::string output, baseline_path, golden_path;
+	double tolerance = 10.0;
+	bool verify_kernels = false, update_golden = false, resolutions_given = false;
+
+	for (int i = 1; i < argc; ++i) {
+		bool has_value = i + 1 < argc;
+
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+			print_usage();
+			return 0;
+		} else if (!strcmp(argv[i], "--quantized")) {
+			settings.quantized = true;
+		} else if (!strcmp(argv[i], "--verify")) {
+			verify_kernels = true;
+		} else if (!strcmp(argv[i], "--update-golden")) {
+			update_golden = true;
+		} else if (!has_value) {
+			std::cerr << "[ERROR] unexpected argument " << argv[i] << std::endl;
+			print_usage();
+			return 1;
+		} else if (!strcmp(argv[i], "--paths")) {
+			settings.paths = argv[++i];
+		} else if (!strcmp(argv[i], "--programs")) {
+			settings.programs = split_list(argv[++i]);
+		} else if (!strcmp(argv[i], "--resolutions")) {
+			settings.resolutions.clear();
+			resolutions_given = true;
+
+			for (const auto& item : split_list(argv[++i])) {
+				settings.resolutions.push_back(static_cast<uint32_t>(atoi(item.c_str())));
+			}
+		} else if (!strcmp(argv[i], "--repeat")) {
+			settings.repeat = static_cast<uint32_t>(atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--threads")) {
+			settings.threads = static_cast<uint32_t>(atoi(argv[++i]));
+
+			if (settings.threads == 0) {
+				std::cerr << "[ERROR] --threads has to be positive" << std::endl;
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "--output")) {
+			output = argv[++i];
+		} else if (!strcmp(argv[i], "--baseline")) {
+			baseline_path = argv[++i];
+		} else if (!strcmp(argv[i], "--tolerance")) {
+			tolerance = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--golden")) {
+			golden_path = argv[++i];
+		} else {
+			std::cerr << "[ERROR] unexpected argument " << argv[i] << std::endl;
+			print_usage();
+			return 1;
+		}
+	}
+
+	if (settings.programs.empty() || settings.resolutions.empty() || settings.repeat == 0 ||
+		std::find(settings.resolutions.begin(), settings.resolutions.end(), 0u) != settings.resolutions.end()) {
+		std::cerr << "[ERROR] programs, resolutions and repeat have to be given and positive" << std::endl;
+		return 1;
+	}
+
+	// nothing used the pool yet, so it is made with as many threads as asked for
+	mini::thread_pool::set_shared_thread_count(settings.threads);
+
+	if (verify_kernels) {
+		// every case is carved several times over, the largest heightmaps would take too long.
+		// the second size lines the mask up with the tiles differently
+		if (!resolutions_given) {
+			settings.resolutions = { 500, 1000 };
+		}
+
+		if (update_golden && golden_path.empty()) {
+			std::cerr << "[ERROR] --update-golden needs the golden file to be given with --golden" << std::endl;
+			return 1;
+		}
+
+		std::vector<verify_golden_t> golden, results;
+
+		if (!golden_path.empty() && !update_golden && !read_golden(golden_path, golden)) {
+			return 1;
+		}
+
+		int failures = verify(settings, golden, results);
+
+		if (failures < 0) {
+			return 1;
+		}
+
+		if (update_golden && !write_golden(golden_path, results)) {
+			return 1;
+		}
+
+		if (failures > 0) {
+			std::cerr << "[WARN] " << failures << " comparisons failed" << std::endl;
+			return 3;
+		}
+
+		std::cerr << "[INFO] every kernel and carving mode matched" << std::endl;
+		return 0;
+	}
+
+	std::vector<bench_case_t> baseline;
+
+	if (!baseline_path.empty() && !read_baseline(baseline_path, baseline)) {
+		return 1;
+	}
+
+	std::vector<bench_case_t> cases;
+	auto start = bench_clock::now();
+
+	for (const auto& program : settings.programs) {
+		for (uint32_t resolution : settings.resolutions) {
+			bench_case_t c = {};
+			c.program = program;
+			c.resolution = resolution;
+
+			if (!run_case(settings, c)) {
+				return 1;
+			}
+
+			std::cerr << "[INFO] " << program << " at " << resolution << "x" << resolution << ": "
+				<< c.wall_time << " s, " << c.stamps / c.carve_time << " stamps/s, "
+				<< c.texels / c.carve_time << " texels/s" << std::endl;
+
+			cases.push_back(c);
+		}
+	}
+
+	double total_time = seconds_since(start);
+
+	if (output.empty()) {
+		write_report(std::cout, settings, cases, total_time);
+	} else {
+		std::ofstream file(output);
+		write_report(file, settings, cases, total_time);
+
+		if (!file) {
+			std::cerr << "[ERROR] failed to write " << output << std::endl;
+			return 1;
+		}
+
+		std::cerr << "[INFO] wrote " << cases.size() << " cases to " << output << std::endl;
+	}
+
+	if (!baseline_path.empty()) {
+		uint32_t regressions = compare_baseline(cases, baseline, tolerance);
+
+		if (regressions > 0) {
+			std::cerr << "[WARN] " << regressions << " out of " << cases.size() << " cases regressed by more than "
+				<< tolerance << "%" << std::endl;
+			return 2;
+		}
+	}
+
+	return 0;
+}
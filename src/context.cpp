@@ -1,6 +1,9 @@
 #include <cassert>
 
 #include "context.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
 
 namespace mini {
 	// basic shaders to render the screen buffer
@@ -37,6 +40,7 @@ namespace mini {
 		m_quad_buffer[1] = 0;
 		m_quad_buffer[2] = 0;
 		m_quad_vao = 0;
+		m_gpu_timer = nullptr;
 
 		m_video_mode = video_mode;
 		m_switch_mode = false;
@@ -89,6 +93,10 @@ namespace mini {
 		m_switch_mode = true;
 	}
 
+	void app_context::set_gpu_timer (gpu_timer * timer) {
+		m_gpu_timer = timer;
+	}
+
 	const video_mode_t & app_context::get_video_mode () const {
 		return m_video_mode;
 	}
@@ -164,11 +172,13 @@ namespace mini {
 		glBindFramebuffer (GL_READ_FRAMEBUFFER, m_framebuffer[back]);
 		glBindFramebuffer (GL_DRAW_FRAMEBUFFER, m_framebuffer[front]);
 
+		m_begin_timer ("resolve", PROFILER_GPU_RESOLVE);
 		glBlitFramebuffer (
 			0, 0, m_video_mode.get_buffer_width (), m_video_mode.get_buffer_height (),
 			0, 0, m_video_mode.get_buffer_width (), m_video_mode.get_buffer_height (),
 			GL_COLOR_BUFFER_BIT, GL_NEAREST
 		);
+		m_end_timer ();
 
 		glBindFramebuffer (GL_FRAMEBUFFER, static_cast<GLuint>(NULL));
 		glBindFramebuffer (GL_READ_FRAMEBUFFER, static_cast<GLuint>(NULL));
@@ -188,6 +198,7 @@ namespace mini {
 		// draw the screen quad
 		glViewport (0, 0, m_video_mode.get_viewport_width (), m_video_mode.get_viewport_height ());
 
+		m_begin_timer ("present", PROFILER_GPU_RESOLVE);
 		glClearColor (0.0f, 0.0f, 0.0f, 1.0f);
 		glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -207,6 +218,8 @@ namespace mini {
 			glBindVertexArray (static_cast<GLuint>(NULL));
 		}
 
+		m_end_timer ();
+
 		// try to switch mode
 		if (m_switch_mode) {
 			m_switch_mode = false;
@@ -215,26 +228,36 @@ namespace mini {
 	}
 
 	void app_context::display_scene (bool clear) {
+		MINI_TRACE_ZONE ("app_context::display_scene");
+
 		glViewport (0, 0, m_video_mode.get_buffer_width (), m_video_mode.get_buffer_height ());
 
 		// clear screen
+		m_begin_timer ("clear", PROFILER_GPU_SCENE);
 		glClearColor (0.15f, 0.15f, 0.15f, 1.0f);
 		glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		m_end_timer ();
 
 		// render the scene
 		if (m_pre_render) {
+			m_begin_timer ("pre render", PROFILER_GPU_SCENE);
 			m_pre_render (*this);
+			m_end_timer ();
 		}
 
 		for (uint32_t index = 0; index < m_last_queue_index; ++index) {
 			auto object_ptr = m_queue[index].object.lock ();
 			if (object_ptr) {
+				m_begin_timer (object_ptr->get_name (), PROFILER_GPU_SCENE);
 				object_ptr->render (*this, m_queue[index].world_matrix);
+				m_end_timer ();
 			}
 		}
 
 		if (m_post_render) {
+			m_begin_timer ("post render", PROFILER_GPU_SCENE);
 			m_post_render (*this);
+			m_end_timer ();
 		}
 
 		// clear the rendering queue
@@ -265,6 +288,18 @@ namespace mini {
 		}
 	}
 
+	void app_context::m_begin_timer (const char * name, uint32_t group) {
+		if (m_gpu_timer) {
+			m_gpu_timer->begin (name, group);
+		}
+	}
+
+	void app_context::m_end_timer () {
+		if (m_gpu_timer) {
+			m_gpu_timer->end ();
+		}
+	}
+
 	void app_context::m_init_frame_buffer () {
 		// values copied from the video mode
 		int32_t render_width = m_video_mode.get_buffer_width ();
@@ -312,6 +347,10 @@ namespace mini {
 
 		glBindTexture (GL_TEXTURE_2D, static_cast<GLuint>(NULL));
 		glBindFramebuffer (GL_FRAMEBUFFER, static_cast<GLuint>(NULL));
+
+		// drivers pad rgb texels to four bytes, depth and stencil take four as well
+		uint64_t pixels = static_cast<uint64_t> (render_width) * render_height;
+		memory_registry::get ().report (this, "framebuffers", 0, pixels * (render_samples * 8 + 4));
 	}
 
 	void app_context::m_init_screen_quad () {
@@ -347,6 +386,8 @@ namespace mini {
 		glDeleteFramebuffers (2, m_framebuffer);
 		glDeleteTextures (2, m_colorbuffer);
 		glDeleteRenderbuffers (1, &m_renderbuffer);
+
+		memory_registry::get ().release (this);
 	}
 
 	void app_context::m_destroy_screen_quad () {
@@ -0,0 +1,44 @@
+#include "alloc.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace mini {
+	// plain globals, operator new may run before any constructor of this file
+	static std::atomic<uint64_t> s_allocations(0);
+	static std::atomic<uint64_t> s_allocated_bytes(0);
+
+	bool allocation_counter::is_enabled() {
+#ifdef MINI_ALLOC_COUNTING_DISABLED
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	allocation_counter::counts_t allocation_counter::get() {
+		return { s_allocations.load(std::memory_order_relaxed), s_allocated_bytes.load(std::memory_order_relaxed) };
+	}
+}
+
+#ifndef MINI_ALLOC_COUNTING_DISABLED
+// the array and nothrow forms go through these by default, aligned allocations are not counted
+void* operator new(std::size_t size) {
+	mini::s_allocations.fetch_add(1, std::memory_order_relaxed);
+	mini::s_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (void* pointer = std::malloc(size ? size : 1)) {
+		return pointer;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+#endif
@@ -0,0 +1,549 @@
+#include "block.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+namespace mini {
+	uint32_t milling_block::get_heightmap_width() const {
+		return m_heightmap_width;
+	}
+
+	uint32_t milling_block::get_heightmap_height() const {
+		return m_heightmap_height;
+	}
+
+	uint32_t milling_block::get_block_width() const {
+		return m_block_width;
+	}
+
+	uint32_t milling_block::get_block_height() const {
+		return m_block_height;
+	}
+
+	uint32_t milling_block::get_tiles_x() const {
+		return (m_heightmap_width + HEIGHTMAP_TILE_MASK) >> HEIGHTMAP_TILE_SHIFT;
+	}
+
+	uint32_t milling_block::get_tiles_y() const {
+		return (m_heightmap_height + HEIGHTMAP_TILE_MASK) >> HEIGHTMAP_TILE_SHIFT;
+	}
+
+	bool milling_block::is_quantized() const {
+		return m_quantized;
+	}
+
+	void milling_block::read_heights(std::vector<float>& out) const {
+		if (!m_quantized) {
+			m_heightmap.read(out);
+			return;
+		}
+
+		std::vector<uint16_t> heights;
+		m_heightmap16.read(heights);
+
+		out.resize(heights.size());
+		std::transform(heights.begin(), heights.end(), out.begin(), height_traits<uint16_t>::decode);
+	}
+
+	const tiled_heightmap& milling_block::get_heightmap() const {
+		return m_heightmap;
+	}
+
+	const tiled_heightmap16& milling_block::get_heightmap16() const {
+		return m_heightmap16;
+	}
+
+	bool milling_block::is_tile_dirty(uint32_t tile_x, uint32_t tile_y) const {
+		return m_dirty_tiles[tile_y * get_tiles_x() + tile_x] != 0;
+	}
+
+	void milling_block::clear_dirty_tiles() {
+		std::fill(m_dirty_tiles.begin(), m_dirty_tiles.end(), 0);
+	}
+
+	bool milling_block::milling_mask_t::is_flat() const {
+		return profile.empty();
+	}
+
+	void milling_block::milling_mask_t::quantize() {
+		quantized.resize(profile.size());
+		std::transform(profile.begin(), profile.end(), quantized.begin(), height_traits<uint16_t>::encode);
+	}
+
+	void milling_block::milling_mask_t::update_bounds() {
+		const uint32_t block_size = 1 << MILLING_MASK_BLOCK_SHIFT;
+
+		blocks_x = (width + block_size - 1) >> MILLING_MASK_BLOCK_SHIFT;
+		uint32_t blocks_y = (height + block_size - 1) >> MILLING_MASK_BLOCK_SHIFT;
+
+		const float outside = std::numeric_limits<float>::infinity();
+
+		block_min.assign(blocks_x * blocks_y, outside);
+		block_max.assign(blocks_x * blocks_y, std::numeric_limits<float>::lowest());
+
+		for (uint32_t y = 0; y < height; ++y) {
+			const carve_span_t& span = spans[y];
+
+			for (uint32_t x = 0; x < width; ++x) {
+				std::size_t block = (y >> MILLING_MASK_BLOCK_SHIFT) * blocks_x + (x >> MILLING_MASK_BLOCK_SHIFT);
+				float value = outside;
+
+				if (x >= span.begin && x < span.end) {
+					std::size_t index = span.offset + (x - span.begin);
+
+					if (!is_flat()) {
+						value = quantized.empty() ? profile[index] : static_cast<float>(quantized[index]);
+					} else {
+						value = 0.0f;
+					}
+				}
+
+				block_min[block] = glm::min(block_min[block], value);
+				block_max[block] = glm::max(block_max[block], value);
+			}
+		}
+
+		lowest = *std::min_element(block_min.begin(), block_min.end());
+	}
+
+	float milling_block::milling_mask_t::get_min(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const {
+		uint32_t begin_x = x >> MILLING_MASK_BLOCK_SHIFT, end_x = (x + width - 1) >> MILLING_MASK_BLOCK_SHIFT;
+		uint32_t begin_y = y >> MILLING_MASK_BLOCK_SHIFT, end_y = (y + height - 1) >> MILLING_MASK_BLOCK_SHIFT;
+
+		float min = block_min[begin_y * blocks_x + begin_x];
+
+		for (uint32_t by = begin_y; by <= end_y; ++by) {
+			for (uint32_t bx = begin_x; bx <= end_x; ++bx) {
+				min = glm::min(min, block_min[by * blocks_x + bx]);
+			}
+		}
+
+		return min;
+	}
+
+	float milling_block::milling_mask_t::get_max(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const {
+		uint32_t begin_x = x >> MILLING_MASK_BLOCK_SHIFT, end_x = (x + width - 1) >> MILLING_MASK_BLOCK_SHIFT;
+		uint32_t begin_y = y >> MILLING_MASK_BLOCK_SHIFT, end_y = (y + height - 1) >> MILLING_MASK_BLOCK_SHIFT;
+
+		float max = block_max[begin_y * blocks_x + begin_x];
+
+		for (uint32_t by = begin_y; by <= end_y; ++by) {
+			for (uint32_t bx = begin_x; bx <= end_x; ++bx) {
+				max = glm::max(max, block_max[by * blocks_x + bx]);
+			}
+		}
+
+		return max;
+	}
+
+	milling_block::carve_stats_t milling_block::get_carve_stats() const {
+		carve_stats_t total = { 0, 0, 0, 0, 0, 0 };
+
+		for (const auto& stats : m_tile_stats) {
+			total.stamps += stats.stamps;
+			total.stamps_culled += stats.stamps_culled;
+			total.tiles += stats.tiles;
+			total.tiles_culled += stats.tiles_culled;
+			total.texels += stats.texels;
+			total.lowered += stats.lowered;
+		}
+
+		return total;
+	}
+
+	void milling_block::reset_carve_stats() {
+		std::fill(m_tile_stats.begin(), m_tile_stats.end(), carve_stats_t{ 0, 0, 0, 0, 0, 0 });
+		m_segment_stats.clear();
+
+		if (m_count_writes) {
+			std::fill(m_write_counts.begin(), m_write_counts.end(), 0);
+
+			// the cleared counts have to reach whatever shows them
+			std::fill(m_dirty_tiles.begin(), m_dirty_tiles.end(), 1);
+		}
+
+		m_report_memory();
+	}
+
+	const std::vector<milling_block::segment_stats_t>& milling_block::get_segment_stats() const {
+		return m_segment_stats;
+	}
+
+	void milling_block::add_segment_stats(uint32_t segment, const milling_result_t& result) {
+		if (segment >= m_segment_stats.size()) {
+			std::size_t capacity = m_segment_stats.capacity();
+			m_segment_stats.resize(segment + 1, segment_stats_t{ 0, 0, 0 });
+
+			if (m_segment_stats.capacity() != capacity) {
+				m_report_memory();
+			}
+		}
+
+		auto& stats = m_segment_stats[segment];
+		stats.stamps++;
+		stats.texels += result.texels;
+		stats.lowered += result.lowered;
+	}
+
+	bool milling_block::is_counting_writes() const {
+		return m_count_writes;
+	}
+
+	void milling_block::set_count_writes(bool count) {
+		if (count == m_count_writes) {
+			return;
+		}
+
+		m_count_writes = count;
+
+		if (count) {
+			m_write_counts.assign(static_cast<std::size_t>(m_heightmap_width) * m_heightmap_height, 0);
+		} else {
+			m_write_counts.clear();
+			m_write_counts.shrink_to_fit();
+		}
+
+		m_report_memory();
+	}
+
+	const std::vector<uint32_t>& milling_block::get_write_counts() const {
+		return m_write_counts;
+	}
+
+	void milling_block::update_bounds() {
+		for (uint32_t ty = 0; ty < get_tiles_y(); ++ty) {
+			for (uint32_t tx = 0; tx < get_tiles_x(); ++tx) {
+				auto& stale = m_stale_tiles[ty * get_tiles_x() + tx];
+
+				if (!stale) {
+					continue;
+				}
+
+				if (m_quantized) {
+					uint16_t min, max;
+					m_heightmap16.get_tile_bounds(tx, ty, min, max);
+					m_pyramid.set_bounds(tx, ty, min, max);
+				} else {
+					float min, max;
+					m_heightmap.get_tile_bounds(tx, ty, min, max);
+					m_pyramid.set_bounds(tx, ty, min, max);
+				}
+
+				stale = 0;
+			}
+		}
+
+		m_pyramid.rebuild();
+	}
+
+	static carve_kernel_t select_kernel(const tiled_heightmap&, bool flat, uint32_t checks) {
+		return carve_kernel::get(flat, checks);
+	}
+
+	static carve_kernel16_t select_kernel(const tiled_heightmap16&, bool flat, uint32_t checks) {
+		return carve_kernel::get16(flat, checks);
+	}
+
+	static uint32_t carve_tile(
+		carve_kernel_t kernel,
+		float* data,
+		const milling_block::milling_mask_t& mask,
+		uint32_t mask_x,
+		uint32_t mask_y,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height) {
+
+		return kernel(data, HEIGHTMAP_TILE_SIZE, mask.spans.data() + mask_y, mask.profile.data(),
+			mask_x, width, height, depth, max_height, min_height);
+	}
+
+	static uint32_t carve_tile(
+		carve_kernel16_t kernel,
+		uint16_t* data,
+		const milling_block::milling_mask_t& mask,
+		uint32_t mask_x,
+		uint32_t mask_y,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height) {
+
+		return kernel(data, HEIGHTMAP_TILE_SIZE, mask.spans.data() + mask_y, mask.quantized.data(),
+			mask_x, width, height,
+			height_traits<uint16_t>::encode_offset(depth),
+			height_traits<uint16_t>::encode_offset(max_height),
+			height_traits<uint16_t>::encode_offset(min_height));
+	}
+
+	static uint32_t carve_tile_counted(
+		float* data,
+		const milling_block::milling_mask_t& mask,
+		uint32_t mask_x,
+		uint32_t mask_y,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered) {
+
+		return carve_counted(data, HEIGHTMAP_TILE_SIZE, mask.spans.data() + mask_y, mask.profile.data(), mask.is_flat(),
+			mask_x, width, height, depth, max_height, min_height, writes, writes_stride, lowered);
+	}
+
+	static uint32_t carve_tile_counted(
+		uint16_t* data,
+		const milling_block::milling_mask_t& mask,
+		uint32_t mask_x,
+		uint32_t mask_y,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered) {
+
+		return carve_counted16(data, HEIGHTMAP_TILE_SIZE, mask.spans.data() + mask_y, mask.quantized.data(), mask.is_flat(),
+			mask_x, width, height,
+			height_traits<uint16_t>::encode_offset(depth),
+			height_traits<uint16_t>::encode_offset(max_height),
+			height_traits<uint16_t>::encode_offset(min_height),
+			writes, writes_stride, lowered);
+	}
+
+	void milling_block::carve_silent(
+		const milling_mask_t& mask, 
+		int32_t offset_x, 
+		int32_t offset_y, 
+		float depth, 
+		float max_height,
+		milling_block::milling_result_t& result) {
+
+		carve_silent(mask, offset_x, offset_y, depth, max_height, { 0, 0, m_heightmap_width, m_heightmap_height }, result);
+	}
+
+	void milling_block::carve_silent(
+		const milling_mask_t& mask,
+		int32_t offset_x,
+		int32_t offset_y,
+		float depth,
+		float max_height,
+		const region_t& region,
+		milling_block::milling_result_t& result) {
+
+		MINI_TRACE_ZONE("milling_block::carve_silent");
+
+		// only the part of the stamp inside the region is carved
+		int32_t begin_x = glm::max(offset_x, static_cast<int32_t>(region.x));
+		int32_t begin_y = glm::max(offset_y, static_cast<int32_t>(region.y));
+		int32_t end_x = glm::min(offset_x + static_cast<int32_t>(mask.width), static_cast<int32_t>(region.x + region.width));
+		int32_t end_y = glm::min(offset_y + static_cast<int32_t>(mask.height), static_cast<int32_t>(region.y + region.height));
+
+		// out of bounds
+		if (begin_x >= end_x || begin_y >= end_y) {
+			return;
+		}
+
+		// errors the result already holds are not looked for again
+		uint32_t checks =
+			(result.collision_error ? 0 : CARVE_COLLISION) |
+			(result.depth_error ? 0 : CARVE_DEPTH);
+
+		uint32_t flags = m_quantized ?
+			m_carve_tiles(m_heightmap16, mask, offset_x, offset_y, depth, max_height, checks, begin_x, begin_y, end_x, end_y, result) :
+			m_carve_tiles(m_heightmap, mask, offset_x, offset_y, depth, max_height, checks, begin_x, begin_y, end_x, end_y, result);
+
+		result.collision_error = result.collision_error || (flags & CARVE_COLLISION);
+		result.depth_error = result.depth_error || (flags & CARVE_DEPTH);
+		result.was_milled = result.was_milled || (flags & CARVE_MILLED);
+	}
+
+	template <typename T> uint32_t milling_block::m_carve_tiles(
+		tiled_heightmap_t<T>& heightmap,
+		const milling_mask_t& mask,
+		int32_t offset_x,
+		int32_t offset_y,
+		float depth,
+		float max_height,
+		uint32_t checks,
+		int32_t begin_x,
+		int32_t begin_y,
+		int32_t end_x,
+		int32_t end_y,
+		milling_result_t& result) {
+
+		// the kernels carve a texel only where mask - depth < height, so nothing below a bound
+		// on the mask minus the depth is ever touched. compared in texel units this is exact
+		const float depth_units = height_traits<T>::to_units(depth);
+
+		auto& stats = m_tile_stats[(begin_y >> HEIGHTMAP_TILE_SHIFT) * get_tiles_x() + (begin_x >> HEIGHTMAP_TILE_SHIFT)];
+		stats.stamps++;
+
+		float highest = m_pyramid.query_max(
+			begin_x >> HEIGHTMAP_TILE_SHIFT, begin_y >> HEIGHTMAP_TILE_SHIFT,
+			(end_x - 1) >> HEIGHTMAP_TILE_SHIFT, (end_y - 1) >> HEIGHTMAP_TILE_SHIFT);
+
+		if (mask.lowest - depth_units >= highest) {
+			stats.stamps_culled++;
+			return 0;
+		}
+
+		// the variant is picked once for the whole stamp
+		const auto kernel = select_kernel(heightmap, mask.is_flat(), checks);
+		uint32_t flags = 0;
+
+		heightmap.for_each_tile(begin_x, begin_y, end_x - begin_x, end_y - begin_y,
+			[&](uint32_t x, uint32_t y, uint32_t width, uint32_t height, T* data) {
+				uint32_t tile_x = x >> HEIGHTMAP_TILE_SHIFT;
+				uint32_t tile_y = y >> HEIGHTMAP_TILE_SHIFT;
+
+				auto& tile_stats = m_tile_stats[tile_y * get_tiles_x() + tile_x];
+				tile_stats.tiles++;
+
+				// the cutter stays above everything in this tile
+				float mask_min = mask.get_min(x - offset_x, y - offset_y, width, height);
+
+				if (mask_min - depth_units >= m_pyramid.get_max(tile_x, tile_y)) {
+					tile_stats.tiles_culled++;
+					return;
+				}
+
+				tile_stats.texels += width * height;
+				result.texels += width * height;
+
+				uint32_t tile_flags;
+
+				if (m_count_writes) {
+					uint64_t lowered = 0;
+
+					tile_flags = carve_tile_counted(data, mask, x - offset_x, y - offset_y, width, height, depth, max_height, m_min_height,
+						m_write_counts.data() + static_cast<std::size_t>(y) * m_heightmap_width + x, m_heightmap_width, lowered);
+
+					tile_stats.lowered += lowered;
+					result.lowered += lowered;
+				} else {
+					tile_flags = carve_tile(kernel, data, mask, x - offset_x, y - offset_y, width, height, depth, max_height, m_min_height);
+				}
+
+				flags |= tile_flags;
+
+				if (!(tile_flags & CARVE_MILLED)) {
+					return;
+				}
+
+				m_mark_dirty(x, y);
+
+				float carved_min = glm::max(mask_min - depth_units, 0.0f);
+
+				bool covered =
+					width == glm::min(HEIGHTMAP_TILE_SIZE, m_heightmap_width - (tile_x << HEIGHTMAP_TILE_SHIFT)) &&
+					height == glm::min(HEIGHTMAP_TILE_SIZE, m_heightmap_height - (tile_y << HEIGHTMAP_TILE_SHIFT));
+
+				float mask_max = covered ? mask.get_max(x - offset_x, y - offset_y, width, height) : 0.0f;
+
+				// the cutter covers the whole tile and lies below all of it, every texel now comes
+				// from the mask and so do the bounds, without rescanning the tile later
+				if (covered && mask_max - depth_units < m_pyramid.get_min(tile_x, tile_y)) {
+					m_pyramid.set_bounds(tile_x, tile_y, carved_min, glm::max(mask_max - depth_units, 0.0f));
+				} else {
+					m_mark_stale(x, y, carved_min);
+				}
+			});
+
+		return flags;
+	}
+
+	void milling_block::m_mark_dirty(uint32_t x, uint32_t y) {
+		m_dirty_tiles[(y >> HEIGHTMAP_TILE_SHIFT) * get_tiles_x() + (x >> HEIGHTMAP_TILE_SHIFT)] = 1;
+	}
+
+	void milling_block::m_mark_stale(uint32_t x, uint32_t y, float min) {
+		m_stale_tiles[(y >> HEIGHTMAP_TILE_SHIFT) * get_tiles_x() + (x >> HEIGHTMAP_TILE_SHIFT)] = 1;
+		m_pyramid.lower_min(x >> HEIGHTMAP_TILE_SHIFT, y >> HEIGHTMAP_TILE_SHIFT, min);
+	}
+
+	void milling_block::set_block_dimensions(uint32_t width, uint32_t height) {
+		m_block_width = width;
+		m_block_height = height;
+		m_heightmap_width = width;
+		m_heightmap_height = height;
+
+		m_init_heightmap();
+	}
+
+	void milling_block::set_block_size(const glm::vec3& scale) {
+		m_block_dimensions = scale;
+	}
+
+	void milling_block::set_block_position(const glm::vec3& position) {
+		m_block_translation = position;
+	}
+
+	const glm::vec3& milling_block::get_block_size() const {
+		return m_block_dimensions;
+	}
+
+	const glm::vec3& milling_block::get_block_position() const {
+		return m_block_translation;
+	}
+
+	milling_block::milling_block(uint32_t width, uint32_t height, float min_height, bool quantized) :
+		m_count_writes(false),
+		m_heightmap_width(width),
+		m_heightmap_height(height),
+		m_block_width(width),
+		m_block_height(height),
+		m_block_dimensions(1.0f),
+		m_block_translation(0.0f),
+		m_min_height(min_height),
+		m_quantized(quantized) {
+
+		m_init_heightmap();
+	}
+
+	milling_block::~milling_block() {
+		memory_registry::get().release(this);
+	}
+
+	void milling_block::m_init_heightmap() {
+		m_dirty_tiles.assign(get_tiles_x() * get_tiles_y(), 0);
+		m_stale_tiles.assign(get_tiles_x() * get_tiles_y(), 0);
+		m_tile_stats.assign(get_tiles_x() * get_tiles_y(), carve_stats_t{ 0, 0, 0, 0, 0, 0 });
+		m_segment_stats.clear();
+
+		if (m_count_writes) {
+			m_write_counts.assign(static_cast<std::size_t>(m_heightmap_width) * m_heightmap_height, 0);
+		}
+
+		if (m_quantized) {
+			m_heightmap16.resize(m_heightmap_width, m_heightmap_height);
+			m_heightmap16.fill(height_traits<uint16_t>::encode(1.0f));
+			m_pyramid.reset(get_tiles_x(), get_tiles_y(), HEIGHTMAP_QUANTIZATION, HEIGHTMAP_QUANTIZATION);
+		} else {
+			m_heightmap.resize(m_heightmap_width, m_heightmap_height);
+			m_heightmap.fill(1.0f);
+			m_pyramid.reset(get_tiles_x(), get_tiles_y(), 1.0f, 1.0f);
+		}
+
+		m_report_memory();
+	}
+
+	void milling_block::m_report_memory() const {
+		auto& registry = memory_registry::get();
+
+		registry.report(this, "block/heightmap", m_heightmap.get_memory_bytes() + m_heightmap16.get_memory_bytes(), 0);
+		registry.report(this, "block/bounds", m_pyramid.get_memory_bytes() + memory_bytes(m_dirty_tiles) +
+			memory_bytes(m_stale_tiles) + memory_bytes(m_tile_stats), 0);
+		registry.report(this, "block/counters", memory_bytes(m_segment_stats) + memory_bytes(m_write_counts), 0);
+	}
+}
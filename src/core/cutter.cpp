@@ -0,0 +1,477 @@
+#include <cassert>
+#include <iostream>
+
+#include "cutter.hpp" 
+#include "memory.hpp"
+#include "pool.hpp"
+#include "trace.hpp"
+
+namespace mini {
+	static milling_block::milling_mask_t make_mask(float radius, bool spherical, const milling_block& block) {
+		assert(radius > 0.0f && "radius has to be positive");
+
+		auto block_size = block.get_block_size();
+		float unit_size_x = block_size.x / block.get_heightmap_width();
+		float unit_size_y = block_size.z / block.get_heightmap_height();
+		float unit_size_z = 1.0f / block_size.y;
+
+		uint32_t mask_width = static_cast<uint32_t>(2*radius / unit_size_x) + 1;
+		uint32_t mask_height = static_cast<uint32_t>(2*radius / unit_size_y) + 1;
+
+		milling_block::milling_mask_t mask(mask_width, mask_height);
+
+		float cx = radius;
+		float cy = radius;
+		float rr = radius * radius;
+
+		// the texels under the cutter form one run per row, only the ball end needs a profile
+		for (uint32_t y = 0; y < mask_height; ++y) {
+			auto& span = mask.spans[y];
+			span.offset = static_cast<uint32_t>(mask.profile.size());
+
+			for (uint32_t x = 0; x < mask_width; ++x) {
+				float rx = x * unit_size_x;
+				float ry = y * unit_size_y;
+
+				float dx = rx - cx;
+				float dy = ry - cy;
+				float d = dx * dx + dy * dy;
+
+				if (d > rr) {
+					if (span.end > span.begin) {
+						break;
+					}
+
+					continue;
+				}
+
+				if (span.end == span.begin) {
+					span.begin = x;
+				}
+
+				span.end = x + 1;
+
+				if (spherical) {
+					mask.profile.push_back((radius - sqrtf(rr - d)) * unit_size_z);
+				}
+			}
+		}
+
+		if (block.is_quantized()) {
+			mask.quantize();
+		}
+
+		mask.update_bounds();
+
+		return mask;
+	}
+
+	// calls fn for every position the cutter stamps at once t of the segment has been travelled,
+	// going back from there in steps relative to the segment
+	template <typename F> static void for_each_stamp(const glm::vec3& start, const glm::vec3& end, float t, float step, F&& fn) {
+		float m = glm::min(1.0f, t);
+
+		while (m > step) {
+			m = m - step;
+			fn(glm::mix(start, end, glm::min(1.0f, t - m)));
+		}
+
+		fn(glm::mix(start, end, glm::min(1.0f, t)));
+	}
+
+	milling_cutter::milling_cutter(
+		std::shared_ptr<const toolpath> path,
+		float blade_height,
+		const milling_block& block) :
+
+		m_mask(make_mask(path->get_radius(), path->is_spherical(), block)),
+		m_path(path),
+		m_path_bytes(path->get_memory_bytes()),
+		m_position(0.0f, -2.5f, 0.0f),
+		m_radius(path->get_radius()),
+		m_spherical(path->is_spherical()),
+		m_interpolation_time(0.0f),
+		m_blade_height(blade_height),
+		m_current_point(0) {
+
+		m_collision_reported = false;
+		m_depth_reported = false;
+		m_flat_reported = false;
+
+		m_report_memory();
+	}
+
+	milling_cutter::~milling_cutter() {
+		memory_registry::get().release(this);
+	}
+
+	float milling_cutter::get_radius() const {
+		return m_radius;
+	}
+
+	bool milling_cutter::is_spherical() const {
+		return m_spherical;
+	}
+
+	const glm::vec3& milling_cutter::get_position() const {
+		return m_position;
+	}
+
+	const std::vector<milling_error_t>& milling_cutter::get_errors() const {
+		return m_errors;
+	}
+
+	bool milling_cutter::update(const float delta_time, milling_block& block) {
+		MINI_TRACE_ZONE("milling_cutter::update");
+		m_interpolation_time += delta_time;
+
+		// a path that is still being read grows between updates
+		if (m_path->get_memory_bytes() != m_path_bytes) {
+			m_path_bytes = m_path->get_memory_bytes();
+			m_report_memory();
+		}
+
+		const std::size_t num_segments = m_path->get_segment_count();
+
+		if (m_current_point < num_segments) {
+			const float step = m_radius * MILLING_STEP;
+
+			while (m_current_point < num_segments) {
+				auto pos_start = m_path->get_point(m_current_point);
+				auto pos_end = m_path->get_point(m_current_point + 1);
+				bool is_vertical = m_path->is_vertical(m_current_point);
+
+				float len = m_path->get_length(m_current_point);
+				float t = m_interpolation_time / len;
+
+				for_each_stamp(pos_start, pos_end, t, step, [&](const glm::vec3& position) {
+					m_position = position;
+					m_carve(block, is_vertical);
+				});
+
+				if (t > 1.0f) {
+					m_interpolation_time -= len;
+					m_current_point++;
+
+					m_collision_reported = false;
+					m_depth_reported = false;
+					m_flat_reported = false;
+				} else {
+					break;
+				}
+			}
+
+			block.update_bounds();
+			return true;
+		}
+
+		// waiting at the end of a path that may still grow, the time spent there is not travelled
+		m_interpolation_time = 0.0f;
+
+		if (m_path->get_point_count() > 0) {
+			m_position = m_path->get_point(m_path->get_point_count() - 1);
+		}
+
+		return false;
+	}
+
+	void milling_cutter::instant(milling_block& block) {
+		MINI_TRACE_ZONE("milling_cutter::instant");
+		const float step = m_radius * MILLING_STEP;
+		const std::size_t num_segments = m_path->get_segment_count();
+
+		const uint32_t tiles_x = block.get_tiles_x();
+		const uint32_t tiles_y = block.get_tiles_y();
+
+		// material removal does not depend on the order of the stamps, but the error checks do,
+		// so every tile is carved by a single worker that goes through its stamps in path order.
+		// every texel then sees exactly the same sequence of stamps as with serial carving
+		auto& stamps = m_scratch.stamps;
+		auto& stamp_results = m_scratch.stamp_results;
+
+		auto& tile_offsets = m_scratch.tile_offsets;
+		auto& tile_stamps = m_scratch.tile_stamps;
+		auto& tile_results = m_scratch.tile_results;
+		auto& active_tiles = m_scratch.active_tiles;
+
+		const auto stats_before = block.get_carve_stats();
+
+		while (m_current_point < num_segments) {
+			std::cout << "[INFO] complete paths " << m_current_point << " out of " << num_segments << std::endl;
+
+			std::size_t batch_end = m_current_point;
+			stamps.clear();
+
+			// a batch takes whole segments until it holds enough stamps
+			for (; batch_end < num_segments && stamps.size() < INSTANT_BATCH_STAMPS; ++batch_end) {
+				const std::size_t segment = batch_end;
+
+				auto pos_start = m_path->get_point(segment);
+				auto pos_end = m_path->get_point(segment + 1);
+				bool is_vertical = m_path->is_vertical(segment);
+
+				float s = step / m_path->get_length(segment);
+
+				for_each_stamp(pos_start, pos_end, 1.0f, s, [&](const glm::vec3& position) {
+					stamps.push_back(m_make_stamp(block, position));
+					stamps.back().segment = static_cast<uint32_t>(segment);
+					stamps.back().vertical = is_vertical;
+				});
+			}
+
+			// bucket the stamps by the tiles they touch. the buckets lie one after another in a
+			// single array, first every tile counts its stamps and then the stamps are dropped in
+			// from the back, which leaves tile_offsets at the start of every bucket
+			tile_offsets.assign(tiles_x * tiles_y + 1, 0);
+
+			auto for_each_tile = [&](const milling_block::region_t& bounds, auto&& fn) {
+				if (bounds.width == 0 || bounds.height == 0) {
+					return;
+				}
+
+				uint32_t tile_begin_x = bounds.x >> HEIGHTMAP_TILE_SHIFT;
+				uint32_t tile_begin_y = bounds.y >> HEIGHTMAP_TILE_SHIFT;
+				uint32_t tile_end_x = (bounds.x + bounds.width - 1) >> HEIGHTMAP_TILE_SHIFT;
+				uint32_t tile_end_y = (bounds.y + bounds.height - 1) >> HEIGHTMAP_TILE_SHIFT;
+
+				for (uint32_t ty = tile_begin_y; ty <= tile_end_y; ++ty) {
+					for (uint32_t tx = tile_begin_x; tx <= tile_end_x; ++tx) {
+						fn(ty * tiles_x + tx);
+					}
+				}
+			};
+
+			for (const auto& stamp : stamps) {
+				for_each_tile(stamp.bounds, [&](uint32_t tile) { tile_offsets[tile]++; });
+			}
+
+			uint32_t total = 0;
+
+			for (uint32_t tile = 0; tile < tiles_x * tiles_y; ++tile) {
+				if (tile_offsets[tile] > 0) {
+					active_tiles.push_back(tile);
+				}
+
+				total += tile_offsets[tile];
+				tile_offsets[tile] = total;
+			}
+
+			tile_offsets[tiles_x * tiles_y] = total;
+			tile_stamps.resize(total);
+			tile_results.resize(total);
+
+			for (std::size_t index = stamps.size(); index-- > 0;) {
+				for_each_tile(stamps[index].bounds, [&](uint32_t tile) {
+					tile_stamps[--tile_offsets[tile]] = static_cast<uint32_t>(index);
+				});
+			}
+
+			auto block_size = block.get_block_size();
+			const float max_height = m_blade_height / block_size.y;
+
+			auto carve_tile = [&](std::size_t k) {
+				uint32_t tile = active_tiles[k];
+				uint32_t tx = tile % tiles_x;
+				uint32_t ty = tile / tiles_x;
+
+				milling_block::region_t region = {
+					tx << HEIGHTMAP_TILE_SHIFT,
+					ty << HEIGHTMAP_TILE_SHIFT,
+					glm::min(HEIGHTMAP_TILE_SIZE, block.get_heightmap_width() - (tx << HEIGHTMAP_TILE_SHIFT)),
+					glm::min(HEIGHTMAP_TILE_SIZE, block.get_heightmap_height() - (ty << HEIGHTMAP_TILE_SHIFT))
+				};
+
+				const uint32_t* bucket = tile_stamps.data() + tile_offsets[tile];
+				milling_block::milling_result_t* results = tile_results.data() + tile_offsets[tile];
+				const uint32_t bucket_size = tile_offsets[tile + 1] - tile_offsets[tile];
+
+				// every error is reported once per segment, so once a stamp found one in this tile
+				// the later stamps of the same segment need not look for it again
+				milling_block::milling_result_t found;
+				uint32_t found_segment = 0;
+
+				for (uint32_t i = 0; i < bucket_size; ++i) {
+					const auto& stamp = stamps[bucket[i]];
+					results[i] = milling_block::milling_result_t();
+
+					if (i == 0 || stamp.segment != found_segment) {
+						found = milling_block::milling_result_t();
+						found_segment = stamp.segment;
+					}
+
+					results[i].collision_error = found.collision_error;
+					results[i].depth_error = found.depth_error;
+
+					block.carve_silent(m_mask, stamp.offset_x, stamp.offset_y, stamp.depth,
+						max_height, region, results[i]);
+
+					found.collision_error = results[i].collision_error;
+					found.depth_error = results[i].depth_error;
+				}
+			};
+
+			// a reference keeps std::function from copying the captures to the heap every batch
+			thread_pool::get().parallel_for(active_tiles.size(), std::ref(carve_tile));
+
+			stamp_results.assign(stamps.size(), milling_block::milling_result_t());
+
+			for (uint32_t tile : active_tiles) {
+				for (uint32_t i = tile_offsets[tile]; i < tile_offsets[tile + 1]; ++i) {
+					const auto& result = tile_results[i];
+					auto& merged = stamp_results[tile_stamps[i]];
+
+					merged.collision_error = merged.collision_error || result.collision_error;
+					merged.depth_error = merged.depth_error || result.depth_error;
+					merged.was_milled = merged.was_milled || result.was_milled;
+					merged.texels += result.texels;
+					merged.lowered += result.lowered;
+				}
+			}
+
+			active_tiles.clear();
+			block.update_bounds();
+
+			// errors are reported in path order, as if the stamps were carved one after another
+			for (std::size_t index = 0; index < stamps.size(); ++index) {
+				if (stamps[index].segment != m_current_point) {
+					m_current_point = stamps[index].segment;
+
+					m_collision_reported = false;
+					m_depth_reported = false;
+					m_flat_reported = false;
+				}
+
+				m_report(stamp_results[index], stamps[index].vertical);
+				block.add_segment_stats(stamps[index].segment, stamp_results[index]);
+			}
+
+			m_current_point = batch_end;
+
+			m_collision_reported = false;
+			m_depth_reported = false;
+			m_flat_reported = false;
+		}
+
+		m_report_memory();
+
+		if (m_path->get_point_count() > 0) {
+			m_position = m_path->get_point(m_path->get_point_count() - 1);
+		}
+
+		const auto stats = block.get_carve_stats();
+
+		std::cout << "[INFO] culled " << stats.stamps_culled - stats_before.stamps_culled << " out of "
+			<< stats.stamps - stats_before.stamps << " stamps and " << stats.tiles_culled - stats_before.tiles_culled
+			<< " out of " << stats.tiles - stats_before.tiles << " tiles" << std::endl;
+
+		if (block.is_counting_writes()) {
+			std::cout << "[INFO] lowered " << stats.lowered - stats_before.lowered << " out of "
+				<< stats.texels - stats_before.texels << " texels visited" << std::endl;
+		}
+	}
+
+	void milling_cutter::m_carve(milling_block& block, bool vertical) {
+		MINI_TRACE_ZONE("milling_cutter::m_carve");
+		auto block_size = block.get_block_size();
+		auto stamp = m_make_stamp(block, m_position);
+
+		// errors already reported on this segment are not checked again
+		milling_block::milling_result_t result;
+		result.collision_error = m_collision_reported;
+		result.depth_error = m_depth_reported;
+
+		block.carve_silent(m_mask, stamp.offset_x, stamp.offset_y, stamp.depth, m_blade_height / block_size.y, result);
+
+		m_report(result, vertical);
+		block.add_segment_stats(m_current_point, result);
+	}
+
+	void milling_cutter::m_report(const milling_block::milling_result_t& result, bool vertical) {
+		std::size_t errors = m_errors.capacity();
+
+		if (result.collision_error && !m_collision_reported) {
+			m_collision_reported = true;
+			m_errors.push_back({ MILLING_ERROR_COLLISION, static_cast<uint32_t>(m_current_point) });
+			std::cerr << "[ERROR] collision reported on path segment " << m_current_point << "!" << std::endl;
+		}
+
+		if (result.depth_error && !m_depth_reported) {
+			m_depth_reported = true;
+			m_errors.push_back({ MILLING_ERROR_DEPTH, static_cast<uint32_t>(m_current_point) });
+			std::cerr << "[ERROR] milling too deep reported on path segment " << m_current_point << "!" << std::endl;
+		}
+
+		if (!m_flat_reported && result.was_milled && vertical && !m_spherical) {
+			m_flat_reported = true;
+			m_errors.push_back({ MILLING_ERROR_FLAT, static_cast<uint32_t>(m_current_point) });
+			std::cerr << "[ERROR] vertical milling with flat cutter on path segment " << m_current_point << "!" << std::endl;
+		}
+
+		if (m_errors.capacity() != errors) {
+			m_report_memory();
+		}
+	}
+
+	void milling_cutter::m_report_memory() const {
+		uint64_t mask = memory_bytes(m_mask.spans) + memory_bytes(m_mask.profile) + memory_bytes(m_mask.quantized) +
+			memory_bytes(m_mask.block_min) + memory_bytes(m_mask.block_max);
+
+		uint64_t batches = memory_bytes(m_scratch.stamps) + memory_bytes(m_scratch.stamp_results) +
+			memory_bytes(m_scratch.tile_offsets) + memory_bytes(m_scratch.tile_stamps) +
+			memory_bytes(m_scratch.tile_results) + memory_bytes(m_scratch.active_tiles);
+
+		auto& registry = memory_registry::get();
+		registry.report(this, "cutter", mask + memory_bytes(m_errors), 0);
+		registry.report(this, "cutter/batches", batches, 0);
+		registry.report(this, "cutter/path", m_path->get_memory_bytes(), 0);
+	}
+
+	static milling_block::region_t clip_bounds(
+		const milling_block& block,
+		int32_t begin_x,
+		int32_t begin_y,
+		int32_t end_x,
+		int32_t end_y) {
+
+		begin_x = glm::max(begin_x, 0);
+		begin_y = glm::max(begin_y, 0);
+		end_x = glm::min(end_x, static_cast<int32_t>(block.get_heightmap_width()));
+		end_y = glm::min(end_y, static_cast<int32_t>(block.get_heightmap_height()));
+
+		if (begin_x >= end_x || begin_y >= end_y) {
+			return { 0, 0, 0, 0 };
+		}
+
+		return {
+			static_cast<uint32_t>(begin_x),
+			static_cast<uint32_t>(begin_y),
+			static_cast<uint32_t>(end_x - begin_x),
+			static_cast<uint32_t>(end_y - begin_y)
+		};
+	}
+
+	milling_cutter::instant_stamp_t milling_cutter::m_make_stamp(const milling_block& block, const glm::vec3& position) const {
+		// calculate the offset
+		auto block_size = block.get_block_size();
+		float unit_size_x = block_size.x / block.get_heightmap_width();
+		float unit_size_y = block_size.z / block.get_heightmap_height();
+
+		auto block_position = block.get_block_position();
+		float relative_x = position.x - block_position.x + block_size.x * 0.5f - m_radius;
+		float relative_y = position.z - block_position.z + block_size.z * 0.5f - m_radius;
+
+		instant_stamp_t stamp = {};
+
+		stamp.offset_x = static_cast<int32_t>(relative_x / unit_size_x);
+		stamp.offset_y = static_cast<int32_t>(relative_y / unit_size_y);
+		stamp.depth = (position.y - block_position.y) / block_size.y;
+
+		stamp.bounds = clip_bounds(block,
+			stamp.offset_x,
+			stamp.offset_y,
+			stamp.offset_x + static_cast<int32_t>(m_mask.width),
+			stamp.offset_y + static_cast<int32_t>(m_mask.height));
+
+		return stamp;
+	}
+}
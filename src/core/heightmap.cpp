@@ -0,0 +1,99 @@
+#include "heightmap.hpp"
+#include <algorithm>
+
+namespace mini {
+	template <typename T> uint32_t tiled_heightmap_t<T>::get_width() const {
+		return m_width;
+	}
+
+	template <typename T> uint32_t tiled_heightmap_t<T>::get_height() const {
+		return m_height;
+	}
+
+	template <typename T> uint32_t tiled_heightmap_t<T>::get_tiles_x() const {
+		return m_tiles_x;
+	}
+
+	template <typename T> uint32_t tiled_heightmap_t<T>::get_tiles_y() const {
+		return m_tiles_y;
+	}
+
+	template <typename T> std::size_t tiled_heightmap_t<T>::get_memory_bytes() const {
+		return m_data.capacity() * sizeof(T);
+	}
+
+	template <typename T> T* tiled_heightmap_t<T>::get_tile(uint32_t tile_x, uint32_t tile_y) {
+		return m_data.data() + (static_cast<std::size_t>(tile_y * m_tiles_x + tile_x) << (2 * HEIGHTMAP_TILE_SHIFT));
+	}
+
+	template <typename T> const T* tiled_heightmap_t<T>::get_tile(uint32_t tile_x, uint32_t tile_y) const {
+		return m_data.data() + (static_cast<std::size_t>(tile_y * m_tiles_x + tile_x) << (2 * HEIGHTMAP_TILE_SHIFT));
+	}
+
+	template <typename T> void tiled_heightmap_t<T>::resize(uint32_t width, uint32_t height) {
+		m_width = width;
+		m_height = height;
+
+		m_tiles_x = (width + HEIGHTMAP_TILE_MASK) >> HEIGHTMAP_TILE_SHIFT;
+		m_tiles_y = (height + HEIGHTMAP_TILE_MASK) >> HEIGHTMAP_TILE_SHIFT;
+
+		m_data.resize(static_cast<std::size_t>(m_tiles_x) * m_tiles_y * HEIGHTMAP_TILE_AREA);
+	}
+
+	template <typename T> void tiled_heightmap_t<T>::fill(T value) {
+		std::fill(m_data.begin(), m_data.end(), value);
+	}
+
+	template <typename T> void tiled_heightmap_t<T>::read(uint32_t x, uint32_t y, uint32_t width, uint32_t height, T* out) const {
+		for (uint32_t row = 0; row < height; ++row) {
+			T* dst = out + static_cast<std::size_t>(row) * width;
+
+			for (uint32_t cx = x; cx < x + width; cx = (cx | HEIGHTMAP_TILE_MASK) + 1) {
+				uint32_t cols = std::min((cx | HEIGHTMAP_TILE_MASK) + 1, x + width) - cx;
+				const T* src = m_data.data() + index(cx, y + row);
+
+				dst = std::copy(src, src + cols, dst);
+			}
+		}
+	}
+
+	template <typename T> void tiled_heightmap_t<T>::read(std::vector<T>& out) const {
+		out.resize(static_cast<std::size_t>(m_width) * m_height);
+		read(0, 0, m_width, m_height, out.data());
+	}
+
+	template <typename T> void tiled_heightmap_t<T>::get_tile_bounds(uint32_t tile_x, uint32_t tile_y, T& min, T& max) const {
+		uint32_t width = std::min(HEIGHTMAP_TILE_SIZE, m_width - (tile_x << HEIGHTMAP_TILE_SHIFT));
+		uint32_t height = std::min(HEIGHTMAP_TILE_SIZE, m_height - (tile_y << HEIGHTMAP_TILE_SHIFT));
+
+		const T* data = get_tile(tile_x, tile_y);
+
+		T lo = data[0], hi = data[0];
+
+		for (uint32_t y = 0; y < height; ++y) {
+			const T* row = data + y * HEIGHTMAP_TILE_SIZE;
+
+			// written out so that the compiler turns it into packed min and max
+			for (uint32_t x = 0; x < width; ++x) {
+				lo = row[x] < lo ? row[x] : lo;
+				hi = row[x] > hi ? row[x] : hi;
+			}
+		}
+
+		min = lo;
+		max = hi;
+	}
+
+	template <typename T> tiled_heightmap_t<T>::tiled_heightmap_t() :
+		m_width(0),
+		m_height(0),
+		m_tiles_x(0),
+		m_tiles_y(0) { }
+
+	template <typename T> tiled_heightmap_t<T>::tiled_heightmap_t(uint32_t width, uint32_t height) : tiled_heightmap_t() {
+		resize(width, height);
+	}
+
+	template class tiled_heightmap_t<float>;
+	template class tiled_heightmap_t<uint16_t>;
+}
@@ -0,0 +1,779 @@
+#include "kernel.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MINI_KERNEL_X86
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MINI_KERNEL_TARGET(isa)
+#else
+#define MINI_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace mini {
+	// clips a mask row to the carved columns, returns the number of texels left and points
+	// heightmap and mask at the first of them. flat cutters have no profile to point at
+	template <bool FLAT, typename T> static inline uint32_t clip_span(
+		const carve_span_t& span,
+		const T* profile,
+		uint32_t x,
+		uint32_t width,
+		T* heightmap,
+		T*& hm,
+		const T*& mask) {
+
+		uint32_t begin = span.begin > x ? span.begin : x;
+		uint32_t end = span.end < x + width ? span.end : x + width;
+
+		hm = heightmap;
+		mask = nullptr;
+
+		if (begin >= end) {
+			return 0;
+		}
+
+		hm = heightmap + (begin - x);
+
+		if constexpr (!FLAT) {
+			mask = profile + span.offset + (begin - span.begin);
+		}
+
+		return end - begin;
+	}
+
+	// shared by every kernel for the texels that do not fill a whole vector
+	template <uint32_t CHECKS> static inline uint32_t carve_texel(
+		float& hm_val, float mask_val, float depth, float max_height, float min_height) {
+
+		float value = mask_val - depth;
+		uint32_t flags = 0;
+
+		if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+			if (value + max_height < hm_val) {
+				flags |= CARVE_COLLISION;
+			}
+		}
+
+		if (value < hm_val) {
+			value = value < 0.0f ? 0.0f : value;
+			hm_val = value;
+
+			flags |= CARVE_MILLED;
+
+			if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+				if (value < min_height) {
+					flags |= CARVE_DEPTH;
+				}
+			}
+		}
+
+		return flags;
+	}
+
+	template <uint32_t CHECKS> static inline uint32_t carve_texel16(
+		uint16_t& hm_val, uint16_t mask_val, int32_t depth, int32_t max_height, int32_t min_height) {
+
+		int32_t value = static_cast<int32_t>(mask_val) - depth;
+		int32_t current = hm_val;
+		uint32_t flags = 0;
+
+		if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+			if (value + max_height < current) {
+				flags |= CARVE_COLLISION;
+			}
+		}
+
+		if (value < current) {
+			value = value < 0 ? 0 : value;
+			hm_val = static_cast<uint16_t>(value);
+
+			flags |= CARVE_MILLED;
+
+			if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+				if (value < min_height) {
+					flags |= CARVE_DEPTH;
+				}
+			}
+		}
+
+		return flags;
+	}
+
+	template <bool FLAT, uint32_t CHECKS> static uint32_t carve_scalar(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height) {
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			float* hm;
+			const float* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+
+			for (uint32_t i = 0; i < count; ++i) {
+				flags |= carve_texel<CHECKS>(hm[i], FLAT ? 0.0f : mask[i], depth, max_height, min_height);
+			}
+		}
+
+		return flags;
+	}
+
+	template <bool FLAT, uint32_t CHECKS> static uint32_t carve_scalar16(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height) {
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			uint16_t* hm;
+			const uint16_t* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+
+			for (uint32_t i = 0; i < count; ++i) {
+				flags |= carve_texel16<CHECKS>(hm[i], FLAT ? 0 : mask[i], depth, max_height, min_height);
+			}
+		}
+
+		return flags;
+	}
+
+	template <bool FLAT, typename T, typename C> static uint32_t carve_counted_rows(
+		T* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const T* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered,
+		C carve) {
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride, writes += writes_stride) {
+			T* hm;
+			const T* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+			uint32_t* row_writes = writes + (hm - heightmap);
+
+			for (uint32_t i = 0; i < count; ++i) {
+				// a texel already at the bottom is reported as milled without changing
+				const T before = hm[i];
+				flags |= carve(hm[i], FLAT ? T(0) : mask[i]);
+
+				if (hm[i] != before) {
+					row_writes[i]++;
+					lowered++;
+				}
+			}
+		}
+
+		return flags;
+	}
+
+	uint32_t carve_counted(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		bool flat,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered) {
+
+		auto carve = [=](float& hm_val, float mask_val) {
+			return carve_texel<CARVE_CHECKS>(hm_val, mask_val, depth, max_height, min_height);
+		};
+
+		if (flat) {
+			return carve_counted_rows<true>(heightmap, heightmap_stride, spans, profile, x, width, height, writes, writes_stride, lowered, carve);
+		}
+
+		return carve_counted_rows<false>(heightmap, heightmap_stride, spans, profile, x, width, height, writes, writes_stride, lowered, carve);
+	}
+
+	uint32_t carve_counted16(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		bool flat,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height,
+		uint32_t* writes,
+		std::size_t writes_stride,
+		uint64_t& lowered) {
+
+		auto carve = [=](uint16_t& hm_val, uint16_t mask_val) {
+			return carve_texel16<CARVE_CHECKS>(hm_val, mask_val, depth, max_height, min_height);
+		};
+
+		if (flat) {
+			return carve_counted_rows<true>(heightmap, heightmap_stride, spans, profile, x, width, height, writes, writes_stride, lowered, carve);
+		}
+
+		return carve_counted_rows<false>(heightmap, heightmap_stride, spans, profile, x, width, height, writes, writes_stride, lowered, carve);
+	}
+
+#ifdef MINI_KERNEL_X86
+	// the vector kernels keep three masks in registers and only turn them into flags once per block,
+	// the heightmap is always written back, texels that are not carved get their own value.
+	// a flat cutter lowers every texel to the same value, so its kernels load no mask, take the
+	// minimum instead of blending and decide the depth error once for the whole block
+	template <bool FLAT, uint32_t CHECKS> MINI_KERNEL_TARGET("sse4.1")
+	static uint32_t carve_sse41(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height) {
+
+		const __m128 v_depth = _mm_set1_ps(depth);
+		const __m128 v_max_height = _mm_set1_ps(max_height);
+		const __m128 v_min_height = _mm_set1_ps(min_height);
+		const __m128 v_zero = _mm_setzero_ps();
+
+		// only used by flat cutters, the carved value and its collision threshold
+		const __m128 v_flat = _mm_sub_ps(v_zero, v_depth);
+		const __m128 v_flat_carved = _mm_max_ps(v_zero, v_flat);
+		const __m128 v_flat_collision = _mm_add_ps(v_flat, v_max_height);
+
+		__m128 v_collision = _mm_setzero_ps();
+		__m128 v_depth_error = _mm_setzero_ps();
+		__m128 v_milled = _mm_setzero_ps();
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			float* hm;
+			const float* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+			uint32_t i = 0;
+
+			for (; i + 4 <= count; i += 4) {
+				__m128 hm_val = _mm_loadu_ps(hm + i);
+
+				if constexpr (FLAT) {
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm_or_ps(v_collision, _mm_cmplt_ps(v_flat_collision, hm_val));
+					}
+
+					v_milled = _mm_or_ps(v_milled, _mm_cmplt_ps(v_flat, hm_val));
+
+					// the height is never below zero, so this is the blend of the carved value
+					_mm_storeu_ps(hm + i, _mm_min_ps(v_flat_carved, hm_val));
+				} else {
+					__m128 value = _mm_sub_ps(_mm_loadu_ps(mask + i), v_depth);
+
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm_or_ps(v_collision, _mm_cmplt_ps(_mm_add_ps(value, v_max_height), hm_val));
+					}
+
+					__m128 cuts = _mm_cmplt_ps(value, hm_val);
+
+					// operand order matches the scalar max, -0 and nan are kept as they are
+					value = _mm_max_ps(v_zero, value);
+
+					v_milled = _mm_or_ps(v_milled, cuts);
+
+					if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+						v_depth_error = _mm_or_ps(v_depth_error, _mm_and_ps(cuts, _mm_cmplt_ps(value, v_min_height)));
+					}
+
+					_mm_storeu_ps(hm + i, _mm_blendv_ps(hm_val, value, cuts));
+				}
+			}
+
+			for (; i < count; ++i) {
+				flags |= carve_texel<CHECKS>(hm[i], FLAT ? 0.0f : mask[i], depth, max_height, min_height);
+			}
+		}
+
+		if (_mm_movemask_ps(v_collision)) {
+			flags |= CARVE_COLLISION;
+		}
+
+		if (_mm_movemask_ps(v_depth_error)) {
+			flags |= CARVE_DEPTH;
+		}
+
+		if (_mm_movemask_ps(v_milled)) {
+			flags |= CARVE_MILLED;
+
+			if constexpr (FLAT && (CHECKS & CARVE_DEPTH) != 0) {
+				if (_mm_cvtss_f32(v_flat_carved) < min_height) {
+					flags |= CARVE_DEPTH;
+				}
+			}
+		}
+
+		return flags;
+	}
+
+	template <bool FLAT, uint32_t CHECKS> MINI_KERNEL_TARGET("avx2")
+	static uint32_t carve_avx2(
+		float* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const float* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		float depth,
+		float max_height,
+		float min_height) {
+
+		const __m256 v_depth = _mm256_set1_ps(depth);
+		const __m256 v_max_height = _mm256_set1_ps(max_height);
+		const __m256 v_min_height = _mm256_set1_ps(min_height);
+		const __m256 v_zero = _mm256_setzero_ps();
+
+		const __m256 v_flat = _mm256_sub_ps(v_zero, v_depth);
+		const __m256 v_flat_carved = _mm256_max_ps(v_zero, v_flat);
+		const __m256 v_flat_collision = _mm256_add_ps(v_flat, v_max_height);
+
+		__m256 v_collision = _mm256_setzero_ps();
+		__m256 v_depth_error = _mm256_setzero_ps();
+		__m256 v_milled = _mm256_setzero_ps();
+
+		// the last partial vector of every row goes through masked loads and stores,
+		// lanes past the end read as zero and have to be kept out of the flags
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			float* hm;
+			const float* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+			uint32_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				__m256 hm_val = _mm256_loadu_ps(hm + i);
+
+				if constexpr (FLAT) {
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm256_or_ps(v_collision, _mm256_cmp_ps(v_flat_collision, hm_val, _CMP_LT_OQ));
+					}
+
+					v_milled = _mm256_or_ps(v_milled, _mm256_cmp_ps(v_flat, hm_val, _CMP_LT_OQ));
+
+					_mm256_storeu_ps(hm + i, _mm256_min_ps(v_flat_carved, hm_val));
+				} else {
+					__m256 value = _mm256_sub_ps(_mm256_loadu_ps(mask + i), v_depth);
+
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm256_or_ps(v_collision,
+							_mm256_cmp_ps(_mm256_add_ps(value, v_max_height), hm_val, _CMP_LT_OQ));
+					}
+
+					__m256 cuts = _mm256_cmp_ps(value, hm_val, _CMP_LT_OQ);
+
+					value = _mm256_max_ps(v_zero, value);
+
+					v_milled = _mm256_or_ps(v_milled, cuts);
+
+					if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+						v_depth_error = _mm256_or_ps(v_depth_error,
+							_mm256_and_ps(cuts, _mm256_cmp_ps(value, v_min_height, _CMP_LT_OQ)));
+					}
+
+					_mm256_storeu_ps(hm + i, _mm256_blendv_ps(hm_val, value, cuts));
+				}
+			}
+
+			if (const uint32_t tail = count - i) {
+				const __m256i tail_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(tail), lanes);
+				const __m256 tail_lanes = _mm256_castsi256_ps(tail_mask);
+
+				__m256 hm_val = _mm256_maskload_ps(hm + i, tail_mask);
+
+				if constexpr (FLAT) {
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm256_or_ps(v_collision,
+							_mm256_and_ps(_mm256_cmp_ps(v_flat_collision, hm_val, _CMP_LT_OQ), tail_lanes));
+					}
+
+					v_milled = _mm256_or_ps(v_milled, _mm256_and_ps(_mm256_cmp_ps(v_flat, hm_val, _CMP_LT_OQ), tail_lanes));
+
+					_mm256_maskstore_ps(hm + i, tail_mask, _mm256_min_ps(v_flat_carved, hm_val));
+				} else {
+					__m256 value = _mm256_sub_ps(_mm256_maskload_ps(mask + i, tail_mask), v_depth);
+
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm256_or_ps(v_collision, _mm256_and_ps(
+							_mm256_cmp_ps(_mm256_add_ps(value, v_max_height), hm_val, _CMP_LT_OQ), tail_lanes));
+					}
+
+					__m256 cuts = _mm256_and_ps(_mm256_cmp_ps(value, hm_val, _CMP_LT_OQ), tail_lanes);
+
+					value = _mm256_max_ps(v_zero, value);
+
+					v_milled = _mm256_or_ps(v_milled, cuts);
+
+					if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+						v_depth_error = _mm256_or_ps(v_depth_error,
+							_mm256_and_ps(cuts, _mm256_cmp_ps(value, v_min_height, _CMP_LT_OQ)));
+					}
+
+					_mm256_maskstore_ps(hm + i, tail_mask, _mm256_blendv_ps(hm_val, value, cuts));
+				}
+			}
+		}
+
+		uint32_t flags = 0;
+
+		if (_mm256_movemask_ps(v_collision)) {
+			flags |= CARVE_COLLISION;
+		}
+
+		if (_mm256_movemask_ps(v_depth_error)) {
+			flags |= CARVE_DEPTH;
+		}
+
+		if (_mm256_movemask_ps(v_milled)) {
+			flags |= CARVE_MILLED;
+
+			if constexpr (FLAT && (CHECKS & CARVE_DEPTH) != 0) {
+				if (_mm256_cvtss_f32(v_flat_carved) < min_height) {
+					flags |= CARVE_DEPTH;
+				}
+			}
+		}
+
+		return flags;
+	}
+
+	// the 16 bit kernels widen every half of a vector to 32 bit lanes, compute exactly like the
+	// scalar kernel and pack the result back with unsigned saturation, which never triggers
+	// since the carved value is always between zero and the previous height
+	template <bool FLAT, uint32_t CHECKS> MINI_KERNEL_TARGET("sse4.1")
+	static uint32_t carve_sse41_16(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height) {
+
+		const __m128i v_depth = _mm_set1_epi32(depth);
+		const __m128i v_max_height = _mm_set1_epi32(max_height);
+		const __m128i v_min_height = _mm_set1_epi32(min_height);
+		const __m128i v_zero = _mm_setzero_si128();
+
+		__m128i v_collision = _mm_setzero_si128();
+		__m128i v_depth_error = _mm_setzero_si128();
+		__m128i v_milled = _mm_setzero_si128();
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			uint16_t* hm;
+			const uint16_t* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+			uint32_t i = 0;
+
+			for (; i < count; i += 8) {
+				// the last vector of a row is moved back to end with it, carving a texel
+				// a second time with the same mask value changes neither it nor the flags
+				if (i + 8 > count) {
+					if (count < 8) {
+						break;
+					}
+
+					i = count - 8;
+				}
+
+				__m128i mask_val = FLAT ? v_zero : _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+				__m128i hm_val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hm + i));
+
+				__m128i halves[2];
+
+				for (int half = 0; half < 2; ++half) {
+					__m128i current = _mm_cvtepu16_epi32(half ? _mm_srli_si128(hm_val, 8) : hm_val);
+					__m128i value = _mm_sub_epi32(_mm_cvtepu16_epi32(half ? _mm_srli_si128(mask_val, 8) : mask_val), v_depth);
+
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm_or_si128(v_collision, _mm_cmplt_epi32(_mm_add_epi32(value, v_max_height), current));
+					}
+
+					__m128i cuts = _mm_cmplt_epi32(value, current);
+
+					value = _mm_max_epi32(value, v_zero);
+
+					v_milled = _mm_or_si128(v_milled, cuts);
+
+					if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+						v_depth_error = _mm_or_si128(v_depth_error, _mm_and_si128(cuts, _mm_cmplt_epi32(value, v_min_height)));
+					}
+
+					halves[half] = _mm_blendv_epi8(current, value, cuts);
+				}
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(hm + i), _mm_packus_epi32(halves[0], halves[1]));
+			}
+
+			for (; i < count; ++i) {
+				flags |= carve_texel16<CHECKS>(hm[i], FLAT ? 0 : mask[i], depth, max_height, min_height);
+			}
+		}
+
+		if (_mm_movemask_epi8(v_collision)) {
+			flags |= CARVE_COLLISION;
+		}
+
+		if (_mm_movemask_epi8(v_depth_error)) {
+			flags |= CARVE_DEPTH;
+		}
+
+		if (_mm_movemask_epi8(v_milled)) {
+			flags |= CARVE_MILLED;
+		}
+
+		return flags;
+	}
+
+	template <bool FLAT, uint32_t CHECKS> MINI_KERNEL_TARGET("avx2")
+	static uint32_t carve_avx2_16(
+		uint16_t* heightmap,
+		std::size_t heightmap_stride,
+		const carve_span_t* spans,
+		const uint16_t* profile,
+		uint32_t x,
+		uint32_t width,
+		uint32_t height,
+		int32_t depth,
+		int32_t max_height,
+		int32_t min_height) {
+
+		const __m256i v_depth = _mm256_set1_epi32(depth);
+		const __m256i v_max_height = _mm256_set1_epi32(max_height);
+		const __m256i v_min_height = _mm256_set1_epi32(min_height);
+		const __m256i v_zero = _mm256_setzero_si256();
+
+		__m256i v_collision = _mm256_setzero_si256();
+		__m256i v_depth_error = _mm256_setzero_si256();
+		__m256i v_milled = _mm256_setzero_si256();
+
+		uint32_t flags = 0;
+
+		for (uint32_t row = 0; row < height; ++row, heightmap += heightmap_stride) {
+			uint16_t* hm;
+			const uint16_t* mask;
+			const uint32_t count = clip_span<FLAT>(spans[row], profile, x, width, heightmap, hm, mask);
+			uint32_t i = 0;
+
+			for (; i < count; i += 16) {
+				// the last vector of a row is moved back to end with it, carving a texel
+				// a second time with the same mask value changes neither it nor the flags
+				if (i + 16 > count) {
+					if (count < 16) {
+						break;
+					}
+
+					i = count - 16;
+				}
+
+				__m256i mask_val = FLAT ? v_zero : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i));
+				__m256i hm_val = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hm + i));
+
+				__m256i halves[2];
+
+				for (int half = 0; half < 2; ++half) {
+					__m256i current = _mm256_cvtepu16_epi32(half ?
+						_mm256_extracti128_si256(hm_val, 1) : _mm256_castsi256_si128(hm_val));
+					__m256i value = _mm256_sub_epi32(_mm256_cvtepu16_epi32(half ?
+						_mm256_extracti128_si256(mask_val, 1) : _mm256_castsi256_si128(mask_val)), v_depth);
+
+					if constexpr ((CHECKS & CARVE_COLLISION) != 0) {
+						v_collision = _mm256_or_si256(v_collision,
+							_mm256_cmpgt_epi32(current, _mm256_add_epi32(value, v_max_height)));
+					}
+
+					__m256i cuts = _mm256_cmpgt_epi32(current, value);
+
+					value = _mm256_max_epi32(value, v_zero);
+
+					v_milled = _mm256_or_si256(v_milled, cuts);
+
+					if constexpr ((CHECKS & CARVE_DEPTH) != 0) {
+						v_depth_error = _mm256_or_si256(v_depth_error,
+							_mm256_and_si256(cuts, _mm256_cmpgt_epi32(v_min_height, value)));
+					}
+
+					halves[half] = _mm256_blendv_epi8(current, value, cuts);
+				}
+
+				// packing works within 128 bit lanes, the permute puts the four quarters back in order
+				__m256i packed = _mm256_packus_epi32(halves[0], halves[1]);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(hm + i), _mm256_permute4x64_epi64(packed, 0xD8));
+			}
+
+			for (; i < count; ++i) {
+				flags |= carve_texel16<CHECKS>(hm[i], FLAT ? 0 : mask[i], depth, max_height, min_height);
+			}
+		}
+
+		if (_mm256_movemask_epi8(v_collision)) {
+			flags |= CARVE_COLLISION;
+		}
+
+		if (_mm256_movemask_epi8(v_depth_error)) {
+			flags |= CARVE_DEPTH;
+		}
+
+		if (_mm256_movemask_epi8(v_milled)) {
+			flags |= CARVE_MILLED;
+		}
+
+		return flags;
+	}
+
+#if defined(_MSC_VER)
+	static bool cpu_supports_sse41() {
+		int info[4];
+		__cpuid(info, 1);
+
+		return (info[2] & (1 << 19)) != 0;
+	}
+
+	static bool cpu_supports_avx2() {
+		int info[4];
+		__cpuid(info, 0);
+
+		if (info[0] < 7) {
+			return false;
+		}
+
+		__cpuid(info, 1);
+
+		// the os has to save the ymm registers, otherwise avx is unusable
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+#else
+	static bool cpu_supports_sse41() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse4.1");
+	}
+
+	static bool cpu_supports_avx2() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+#endif
+
+	// every combination of cutter and checks, indexed like carve_kernel::selection_t
+#define MINI_KERNEL_VARIANTS(kernel) { \
+	{ kernel<false, 0>, kernel<false, 1>, kernel<false, 2>, kernel<false, 3> }, \
+	{ kernel<true, 0>, kernel<true, 1>, kernel<true, 2>, kernel<true, 3> } }
+
+	static_assert(CARVE_COLLISION == 1 && CARVE_DEPTH == 2, "kernel variants are indexed by their checks");
+
+	carve_kernel_t carve_kernel::get(bool flat, uint32_t checks) {
+		return m_select().kernels[flat][checks & CARVE_CHECKS];
+	}
+
+	carve_kernel16_t carve_kernel::get16(bool flat, uint32_t checks) {
+		return m_select().kernels16[flat][checks & CARVE_CHECKS];
+	}
+
+	std::string_view carve_kernel::get_name() {
+		return m_select().name;
+	}
+
+	std::vector<std::string_view> carve_kernel::get_available() {
+		std::vector<std::string_view> names;
+
+		for (const auto& selection : m_available()) {
+			names.push_back(selection.name);
+		}
+
+		return names;
+	}
+
+	bool carve_kernel::select(std::string_view name) {
+		for (const auto& selection : m_available()) {
+			if (selection.name == name) {
+				m_current() = &selection;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	const std::vector<carve_kernel::selection_t>& carve_kernel::m_available() {
+		static const std::vector<selection_t> available = []() {
+			std::vector<selection_t> selections;
+
+#ifdef MINI_KERNEL_X86
+			if (cpu_supports_avx2()) {
+				selections.push_back({ MINI_KERNEL_VARIANTS(carve_avx2), MINI_KERNEL_VARIANTS(carve_avx2_16), "avx2" });
+			}
+
+			if (cpu_supports_sse41()) {
+				selections.push_back({ MINI_KERNEL_VARIANTS(carve_sse41), MINI_KERNEL_VARIANTS(carve_sse41_16), "sse4.1" });
+			}
+#endif
+			selections.push_back({ MINI_KERNEL_VARIANTS(carve_scalar), MINI_KERNEL_VARIANTS(carve_scalar16), "scalar" });
+			return selections;
+		}();
+
+		return available;
+	}
+
+	const carve_kernel::selection_t*& carve_kernel::m_current() {
+		static const selection_t* current = &m_available().front();
+		return current;
+	}
+
+	const carve_kernel::selection_t& carve_kernel::m_select() {
+		return *m_current();
+	}
+}
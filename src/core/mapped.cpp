@@ -0,0 +1,136 @@
+#include "mapped.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mini {
+	bool mapped_file::is_open() const {
+		return m_open;
+	}
+
+	const char* mapped_file::get_data() const {
+		return m_data;
+	}
+
+	std::size_t mapped_file::get_size() const {
+		return m_size;
+	}
+
+#if defined(_WIN32)
+	mapped_file::mapped_file(const std::string& path) : m_data(nullptr), m_size(0), m_open(false), m_file(nullptr), m_mapping(nullptr) {
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		m_file = file;
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size)) {
+			m_close();
+			return;
+		}
+
+		// a mapping of nothing cannot be created
+		if (size.QuadPart == 0) {
+			m_open = true;
+			return;
+		}
+
+		m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (m_mapping == nullptr) {
+			m_close();
+			return;
+		}
+
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (m_data == nullptr) {
+			m_close();
+			return;
+		}
+
+		m_size = static_cast<std::size_t>(size.QuadPart);
+		m_open = true;
+	}
+
+	void mapped_file::m_close() {
+		if (m_data != nullptr) {
+			UnmapViewOfFile(m_data);
+		}
+
+		if (m_mapping != nullptr) {
+			CloseHandle(m_mapping);
+		}
+
+		if (m_file != nullptr) {
+			CloseHandle(m_file);
+		}
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+		m_file = nullptr;
+		m_mapping = nullptr;
+	}
+#else
+	mapped_file::mapped_file(const std::string& path) : m_data(nullptr), m_size(0), m_open(false), m_file(nullptr), m_mapping(nullptr) {
+		int descriptor = open(path.c_str(), O_RDONLY);
+
+		if (descriptor < 0) {
+			return;
+		}
+
+		struct stat status;
+
+		if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+			close(descriptor);
+			return;
+		}
+
+		if (status.st_size == 0) {
+			close(descriptor);
+			m_open = true;
+			return;
+		}
+
+		void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+
+		if (data == MAP_FAILED) {
+			return;
+		}
+
+		// the file is read once from start to end
+		madvise(data, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+
+		m_data = static_cast<const char*>(data);
+		m_size = static_cast<std::size_t>(status.st_size);
+		m_open = true;
+	}
+
+	void mapped_file::m_close() {
+		if (m_data != nullptr) {
+			munmap(const_cast<char*>(m_data), m_size);
+		}
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+	}
+#endif
+
+	mapped_file::~mapped_file() {
+		m_close();
+	}
+}
@@ -0,0 +1,103 @@
+#include "memory.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace mini {
+	void memory_registry::report(const void* owner, const char* name, uint64_t host_bytes, uint64_t gpu_bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = std::find_if(m_reports.begin(), m_reports.end(), [&](const report_t& report) {
+			return report.owner == owner && !strcmp(report.name, name);
+		});
+
+		if (it != m_reports.end()) {
+			m_host_bytes -= it->host_bytes;
+			m_gpu_bytes -= it->gpu_bytes;
+			it->host_bytes = host_bytes;
+			it->gpu_bytes = gpu_bytes;
+		} else {
+			m_reports.push_back(report_t{ owner, name, host_bytes, gpu_bytes });
+		}
+
+		m_host_bytes += host_bytes;
+		m_gpu_bytes += gpu_bytes;
+		m_peak_host_bytes = std::max(m_peak_host_bytes, m_host_bytes);
+		m_peak_gpu_bytes = std::max(m_peak_gpu_bytes, m_gpu_bytes);
+	}
+
+	void memory_registry::release(const void* owner) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto end = std::remove_if(m_reports.begin(), m_reports.end(), [&](const report_t& report) {
+			if (report.owner != owner) {
+				return false;
+			}
+
+			m_host_bytes -= report.host_bytes;
+			m_gpu_bytes -= report.gpu_bytes;
+			return true;
+		});
+
+		m_reports.erase(end, m_reports.end());
+	}
+
+	void memory_registry::get_usage(std::vector<usage_t>& out) const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		out.clear();
+
+		for (const auto& report : m_reports) {
+			auto it = std::find_if(out.begin(), out.end(), [&](const usage_t& usage) {
+				return !strcmp(usage.name, report.name);
+			});
+
+			if (it == out.end()) {
+				out.push_back(usage_t{ report.name, 1, report.host_bytes, report.gpu_bytes });
+			} else {
+				it->owners++;
+				it->host_bytes += report.host_bytes;
+				it->gpu_bytes += report.gpu_bytes;
+			}
+		}
+
+		std::sort(out.begin(), out.end(), [](const usage_t& a, const usage_t& b) {
+			return strcmp(a.name, b.name) < 0;
+		});
+	}
+
+	uint64_t memory_registry::get_host_bytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_host_bytes;
+	}
+
+	uint64_t memory_registry::get_gpu_bytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_gpu_bytes;
+	}
+
+	uint64_t memory_registry::get_peak_host_bytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_peak_host_bytes;
+	}
+
+	uint64_t memory_registry::get_peak_gpu_bytes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_peak_gpu_bytes;
+	}
+
+	void memory_registry::reset_peak() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_peak_host_bytes = m_host_bytes;
+		m_peak_gpu_bytes = m_gpu_bytes;
+	}
+
+	memory_registry::memory_registry() :
+		m_host_bytes(0),
+		m_gpu_bytes(0),
+		m_peak_host_bytes(0),
+		m_peak_gpu_bytes(0) { }
+
+	memory_registry& memory_registry::get() {
+		static memory_registry registry;
+		return registry;
+	}
+}
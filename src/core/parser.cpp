@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ios>
+#include <string>
+#include <iostream>
+
+#include "parser.hpp"
+#include "pool.hpp"
+#include "trace.hpp"
+
+namespace mini {
+	// same as getline, the last line needs no line break and nothing after it is no line
+	static bool read_mapped_line(const char* data, std::size_t size, std::size_t& position, std::string_view& line) {
+		if (position >= size) {
+			return false;
+		}
+
+		const char* begin = data + position;
+		const char* end = static_cast<const char*>(std::memchr(begin, '\n', size - position));
+		std::size_t length = end != nullptr ? static_cast<std::size_t>(end - begin) : size - position;
+
+		line = std::string_view(begin, length);
+		position += length + 1;
+
+		return true;
+	}
+
+	static inline uint64_t hash_word(uint64_t hash, uint64_t word) {
+		hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+		return hash ^ (hash >> 32);
+	}
+
+	source_hash::source_hash() :
+		m_lanes { 0x9e3779b97f4a7c15ull, 0x6a09e667f3bcc909ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull },
+		m_buffered(0),
+		m_size(0) { }
+
+	void source_hash::update(const char* data, std::size_t size) {
+		m_size += size;
+
+		// a line rarely fills a block, so its bytes wait for the next ones
+		if (m_buffered > 0) {
+			std::size_t count = std::min(size, sizeof(m_block) - m_buffered);
+			std::memcpy(m_block + m_buffered, data, count);
+
+			m_buffered += count;
+			data += count;
+			size -= count;
+
+			if (m_buffered < sizeof(m_block)) {
+				return;
+			}
+
+			uint64_t words[4];
+			std::memcpy(words, m_block, sizeof(words));
+
+			for (int lane = 0; lane < 4; ++lane) {
+				m_lanes[lane] = hash_word(m_lanes[lane], words[lane]);
+			}
+
+			m_buffered = 0;
+		}
+
+		for (; size >= sizeof(m_block); data += sizeof(m_block), size -= sizeof(m_block)) {
+			uint64_t words[4];
+			std::memcpy(words, data, sizeof(words));
+
+			for (int lane = 0; lane < 4; ++lane) {
+				m_lanes[lane] = hash_word(m_lanes[lane], words[lane]);
+			}
+		}
+
+		std::memcpy(m_block, data, size);
+		m_buffered = size;
+	}
+
+	uint64_t source_hash::get_size() const {
+		return m_size;
+	}
+
+	uint64_t source_hash::get_value() const {
+		uint64_t hash = m_lanes[0];
+
+		for (int lane = 1; lane < 4; ++lane) {
+			hash = hash_word(hash, m_lanes[lane]);
+		}
+
+		for (std::size_t i = 0; i < m_buffered; i += sizeof(uint64_t)) {
+			uint64_t tail = 0;
+			std::memcpy(&tail, m_block + i, std::min(sizeof(tail), m_buffered - i));
+			hash = hash_word(hash, tail);
+		}
+
+		hash = hash_word(hash, m_size);
+		return hash_word(hash, 0xc4ceb9fe1a85ec53ull);
+	}
+
+	milling_command_parser::milling_command_parser(const std::string& path, bool mapped) : m_position(0) { 
+		m_previous_line = 0;
+
+		if (mapped) {
+			m_mapped = std::make_unique<mapped_file>(path);
+
+			if (!m_mapped->is_open()) {
+				m_mapped.reset();
+			}
+		}
+
+		// binary, as the mapping keeps every byte and both are hashed alike
+		if (!m_mapped) {
+			m_stream.open(path, std::ios::binary);
+		}
+
+		m_parsers[1] = std::bind(&milling_command_parser::m_read_g01_command, this, std::placeholders::_1, std::placeholders::_2);
+	}
+
+	bool milling_command_parser::is_good() const {
+		if (m_mapped) {
+			return m_position < m_mapped->get_size();
+		}
+
+		return m_stream.good();
+	}
+
+	bool milling_command_parser::is_mapped() const {
+		return m_mapped != nullptr;
+	}
+
+	bool milling_command_parser::m_read_line(std::string_view& line) {
+		if (!m_mapped) {
+			// the line keeps its buffer between calls, so reading a line allocates nothing
+			if (!std::getline(m_stream, m_line)) {
+				return false;
+			}
+
+			// only the last line of the file can end without a line break
+			m_source.update(m_line.data(), m_line.size());
+
+			if (!m_stream.eof()) {
+				m_source.update("\n", 1);
+			}
+
+			line = m_line;
+			return true;
+		}
+
+		const std::size_t begin = m_position;
+		const std::size_t size = m_mapped->get_size();
+
+		if (!read_mapped_line(m_mapped->get_data(), size, m_position, line)) {
+			return false;
+		}
+
+		m_source.update(m_mapped->get_data() + begin, std::min(m_position, size) - begin);
+		return true;
+	}
+
+	std::optional<milling_command> milling_command_parser::get_next_command() {
+		std::string_view line;
+
+		if (m_read_line(line)) {
+			std::optional<int> line_number;
+			auto command = m_parse_line(line, line_number);
+
+			if (line_number.has_value()) {
+				m_check_line(line_number.value(), m_previous_line);
+			}
+
+			if (command.has_value()) {
+				m_previous_line = line_number.value();
+			}
+
+			return command;
+		}
+
+		return std::nullopt;
+	}
+
+	std::vector<milling_command> milling_command_parser::get_commands() {
+		MINI_TRACE_ZONE("milling_command_parser::get_commands");
+
+		auto command = get_next_command();
+		std::vector<milling_command> commands;
+
+		while (command.has_value()) {
+			commands.push_back(command.value());
+			command = get_next_command();
+		}
+
+		return commands;
+	}
+
+	std::vector<milling_command> milling_command_parser::get_commands_parallel() {
+		MINI_TRACE_ZONE("milling_command_parser::get_commands_parallel");
+
+		auto& pool = thread_pool::get();
+		const std::size_t begin = m_position;
+		const std::size_t size = m_mapped ? m_mapped->get_size() : 0;
+		const std::size_t chunk_count = std::min<std::size_t>((size - std::min(begin, size)) / PARSER_CHUNK_SIZE, pool.get_thread_count() * 4);
+
+		if (chunk_count < 2) {
+			return get_commands();
+		}
+
+		// chunks start right after a line break, so no line is split between two of them
+		const char* data = m_mapped->get_data();
+		std::vector<std::size_t> starts(chunk_count + 1, size);
+		starts[0] = begin;
+
+		for (std::size_t i = 1; i < chunk_count; ++i) {
+			std::size_t start = std::max(starts[i - 1], begin + (size - begin) * i / chunk_count);
+			const char* line_break = start < size ? static_cast<const char*>(std::memchr(data + start, '\n', size - start)) : nullptr;
+			starts[i] = line_break != nullptr ? static_cast<std::size_t>(line_break - data) + 1 : size;
+		}
+
+		std::vector<chunk_t> chunks(chunk_count);
+
+		auto parse_chunk = [&](std::size_t index) {
+			MINI_TRACE_ZONE("milling_command_parser::parse_chunk");
+			m_parse_chunk(data, starts[index], starts[index + 1], chunks[index]);
+		};
+
+		pool.parallel_for(chunk_count, std::ref(parse_chunk));
+
+		// the first line of every chunk is checked against the last line of the chunks before it,
+		// and a line that ends parsing drops every chunk after its own, as if read one by one
+		std::size_t command_count = 0;
+
+		for (const auto& chunk : chunks) {
+			command_count += chunk.commands.size();
+		}
+
+		std::vector<milling_command> commands;
+		commands.reserve(command_count);
+
+		for (auto& chunk : chunks) {
+			if (chunk.first_line.has_value()) {
+				m_check_line(chunk.first_line.value(), m_previous_line);
+			}
+
+			for (const auto& warning : chunk.warnings) {
+				m_check_line(warning.line, warning.previous);
+			}
+
+			commands.insert(commands.end(), chunk.commands.begin(), chunk.commands.end());
+
+			if (chunk.last_line.has_value()) {
+				m_previous_line = chunk.last_line.value();
+			}
+
+			if (chunk.stopped) {
+				break;
+			}
+		}
+
+		// the chunks were read straight from the mapping, which is hashed in one go once they are
+		m_source.update(data + begin, size - begin);
+
+		m_position = size;
+		return commands;
+	}
+
+	const source_hash& milling_command_parser::get_source_hash() const {
+		return m_source;
+	}
+
+	void milling_command_parser::m_parse_chunk(const char* data, std::size_t begin, std::size_t end, chunk_t& chunk) const {
+		std::string_view line;
+		std::size_t position = begin;
+		std::size_t previous = 0;
+
+		while (read_mapped_line(data, end, position, line)) {
+			std::optional<int> line_number;
+			auto command = m_parse_line(line, line_number);
+
+			if (line_number.has_value()) {
+				if (!chunk.last_line.has_value()) {
+					chunk.first_line = line_number;
+				} else if (line_number.value() - previous != 1) {
+					chunk.warnings.push_back({ line_number.value(), previous });
+				}
+			}
+
+			if (!command.has_value()) {
+				chunk.stopped = true;
+				return;
+			}
+
+			previous = line_number.value();
+			chunk.last_line = previous;
+			chunk.commands.push_back(command.value());
+		}
+	}
+
+	std::optional<milling_command> milling_command_parser::m_parse_line(std::string_view line, std::optional<int>& line_number) const {
+		const char* iter = line.data();
+
+		if (m_get(line, iter) != 'N') {
+			return std::nullopt;
+		}
+
+		line_number = m_try_read_int(line, iter);
+		if (!line_number.has_value()) {
+			return std::nullopt;
+		}
+
+		if (m_get(line, iter) != 'G') {
+			return std::nullopt;
+		}
+
+		auto command_number_opt = m_try_read_int(line, iter);
+		if (!command_number_opt.has_value()) {
+			return std::nullopt;
+		}
+
+		auto command_number = command_number_opt.value();
+		if (command_number < 0 || command_number > 99) {
+			return std::nullopt;
+		}
+
+		auto parser = m_parsers.find(command_number);
+		if (parser == m_parsers.end()) {
+			return std::nullopt;
+		}
+
+		return parser->second(line, iter);
+	}
+
+	void milling_command_parser::m_check_line(int line_number, std::size_t previous) const {
+		if (line_number - previous != 1) {
+			std::cerr << "milling format warning: line is " << line_number << ", previous was " << previous << std::endl;
+		}
+	}
+
+	milling_command milling_command_parser::m_read_g01_command(std::string_view line, const char*& iter) const {
+		if (m_get(line, iter) != 'X') {
+			return milling_command(command_invalid());
+		}
+
+		auto x_opt = m_try_read_float(line, iter);
+
+		if (!x_opt.has_value()) {
+			return milling_command(command_invalid());
+		}
+
+		if (m_get(line, iter) != 'Y') {
+			return milling_command(command_invalid());
+		}
+
+		auto y_opt = m_try_read_float(line, iter);
+
+		if (!y_opt.has_value()) {
+			return milling_command(command_invalid());
+		}
+
+		if (m_get(line, iter) != 'Z') {
+			return milling_command(command_invalid());
+		}
+
+		auto z_opt = m_try_read_float(line, iter);
+
+		if (!z_opt.has_value()) {
+			return milling_command(command_invalid());
+		}
+
+		return milling_command(command_g01_t{
+			x_opt.value(), y_opt.value(), z_opt.value()
+		});
+	}
+
+	char milling_command_parser::m_peek(std::string_view line, const char*& iter) const {
+		if (iter == line.data() + line.size()) {
+			return '\0';
+		}
+
+		return *iter;
+	}
+
+	char milling_command_parser::m_get(std::string_view line, const char*& iter) const {
+		if (iter == line.data() + line.size()) {
+			return '\0';
+		}
+
+		auto ch = *iter;
+		iter++;
+
+		return ch;
+	}
+
+	std::optional<int> milling_command_parser::m_try_read_int(std::string_view line, const char*& iter) const {
+		auto begin = iter;
+		auto first_char = m_peek(line, iter);
+
+		if (first_char < '0' || first_char > '9') {
+			return std::nullopt;
+		}
+
+		while (iter != line.data() + line.size()) {
+			if (*iter >= '0' && *iter <= '9') {
+				iter++;
+			} else {
+				break;
+			}
+		}
+
+		// parsed in place, a temporary string per number would allocate
+		int value = 0;
+		auto [end, error] = std::from_chars(begin, iter, value);
+
+		if (error != std::errc()) {
+			return std::nullopt;
+		}
+
+		return value;
+	}
+
+	std::optional<float> milling_command_parser::m_try_read_float(std::string_view line, const char*& iter) const {
+		auto begin = iter;
+		bool after_dot = false;
+		int chars_after_dot = 0;
+
+		// the digits are gathered into a whole number of thousandths on the way, for the usual form
+		uint64_t thousandths = 0;
+		int digits = 0;
+		int dots = 0;
+
+		while (iter != line.data() + line.size()) {
+			if (*iter >= '0' && *iter <= '9') {
+				thousandths = thousandths * 10 + static_cast<uint64_t>(*iter - '0');
+				digits++;
+				iter++;
+
+				if (after_dot) {
+					chars_after_dot++;
+				}
+			} else if (*iter == '.') {
+				if (iter == begin) {
+					return std::nullopt;
+				}
+
+				after_dot = true;
+				dots++;
+				iter++;
+			} else if (*iter == '-') {
+				if (iter != begin) {
+					return std::nullopt;
+				}
+
+				iter++;
+			} else {
+				break;
+			}
+		}
+
+		if (chars_after_dot != 3) {
+			return std::nullopt;
+		}
+
+		// digits, a single dot and three decimals. the division rounds correctly, so this gives
+		// what from_chars does as long as the number fits the float mantissa
+		if (dots == 1 && digits >= 4 && digits <= 7) {
+			float value = static_cast<float>(thousandths) / 1000.0f;
+			return *begin == '-' ? -value : value;
+		}
+
+		float value = 0.0f;
+		auto [end, error] = std::from_chars(begin, iter, value);
+
+		if (error != std::errc()) {
+			return std::nullopt;
+		}
+
+		return value;
+	}
+}
@@ -0,0 +1,131 @@
+#include "pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <string>
+
+namespace mini {
+	uint32_t thread_pool::get_thread_count() const {
+		return static_cast<uint32_t>(m_workers.size()) + 1;
+	}
+
+	void thread_pool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn) {
+		if (count == 0) {
+			return;
+		}
+
+		if (m_workers.empty() || count == 1) {
+			for (std::size_t i = 0; i < count; ++i) {
+				fn(i);
+			}
+
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_task = &fn;
+			m_task_size = count;
+			m_next_index.store(0, std::memory_order_relaxed);
+			m_busy_workers = static_cast<uint32_t>(m_workers.size());
+			m_generation++;
+		}
+
+		m_wake_cv.notify_all();
+		m_drain();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done_cv.wait(lock, [this]() { return m_busy_workers == 0; });
+		m_task = nullptr;
+	}
+
+	void thread_pool::m_drain() {
+		while (true) {
+			std::size_t index = m_next_index.fetch_add(1, std::memory_order_relaxed);
+
+			if (index >= m_task_size) {
+				break;
+			}
+
+			(*m_task)(index);
+		}
+	}
+
+	void thread_pool::m_worker_loop(uint32_t index) {
+		uint64_t seen_generation = 0;
+		trace_recorder::get().set_thread_name("pool worker " + std::to_string(index));
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake_cv.wait(lock, [&]() { return m_stop || m_generation != seen_generation; });
+
+				if (m_stop) {
+					return;
+				}
+
+				seen_generation = m_generation;
+			}
+
+			m_drain();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				if (--m_busy_workers == 0) {
+					m_done_cv.notify_one();
+				}
+			}
+		}
+	}
+
+	thread_pool::thread_pool(uint32_t workers) :
+		m_task(nullptr),
+		m_task_size(0),
+		m_next_index(0),
+		m_generation(0),
+		m_busy_workers(0),
+		m_stop(false) {
+
+		for (uint32_t i = 0; i < workers; ++i) {
+			m_workers.emplace_back(&thread_pool::m_worker_loop, this, i);
+		}
+	}
+
+	thread_pool::~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_wake_cv.notify_all();
+
+		for (auto& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	// set before the shared pool is first used, from the thread that goes on to use it
+	static std::atomic<uint32_t> shared_thread_count(0);
+	static std::atomic<bool> shared_created(false);
+
+	thread_pool& thread_pool::get() {
+		static thread_pool pool([]() {
+			uint32_t threads = shared_thread_count.load(std::memory_order_relaxed);
+			shared_created.store(true, std::memory_order_relaxed);
+
+			return (threads > 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u)) - 1;
+		}());
+
+		return pool;
+	}
+
+	bool thread_pool::set_shared_thread_count(uint32_t threads) {
+		if (shared_created.load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		shared_thread_count.store(threads, std::memory_order_relaxed);
+		return true;
+	}
+}
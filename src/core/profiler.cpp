@@ -0,0 +1,100 @@
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace mini {
+	const char* frame_profiler::get_series_name(uint32_t series) {
+		switch (series) {
+			case PROFILER_FRAME: return "Frame";
+			case PROFILER_CARVE: return "Carving";
+			case PROFILER_UPLOAD: return "Upload";
+			case PROFILER_DISPLAY: return "Display";
+			case PROFILER_GUI: return "GUI";
+			case PROFILER_GPU_SCENE: return "GPU Scene";
+			case PROFILER_GPU_RESOLVE: return "GPU Resolve";
+			case PROFILER_GPU_GUI: return "GPU GUI";
+			case PROFILER_STAMPS: return "Stamps";
+			case PROFILER_TEXELS: return "Texels";
+			case PROFILER_UPLOAD_BYTES: return "Bytes Uploaded";
+			default: return "";
+		}
+	}
+
+	uint32_t frame_profiler::get_frames() const {
+		return m_frames;
+	}
+
+	void frame_profiler::get_history(uint32_t series, uint32_t frames, std::vector<float>& out) const {
+		frames = std::min(frames, m_frames);
+		out.resize(frames);
+
+		const float* row = m_history.data() + series * PROFILER_HISTORY;
+		uint32_t first = (m_next + PROFILER_HISTORY - frames) % PROFILER_HISTORY;
+
+		for (uint32_t i = 0; i < frames; ++i) {
+			out[i] = row[(first + i) % PROFILER_HISTORY];
+		}
+	}
+
+	frame_profiler::summary_t frame_profiler::get_summary(uint32_t series, uint32_t frames) const {
+		std::vector<float> values;
+		get_history(series, frames, values);
+
+		if (values.empty()) {
+			return { 0.0f, 0.0f, 0.0f };
+		}
+
+		summary_t summary = { values[0], 0.0f, 0.0f };
+
+		for (float value : values) {
+			summary.min = std::min(summary.min, value);
+			summary.average += value;
+		}
+
+		summary.average /= values.size();
+
+		// nearest rank, the smallest value that at least 99% of the frames do not exceed
+		std::size_t rank = (values.size() * 99 + 99) / 100 - 1;
+		std::nth_element(values.begin(), values.begin() + rank, values.end());
+		summary.p99 = values[rank];
+
+		return summary;
+	}
+
+	void frame_profiler::begin_frame() {
+		m_current.fill(0.0f);
+		m_started[PROFILER_FRAME] = std::chrono::steady_clock::now();
+	}
+
+	void frame_profiler::end_frame() {
+		end(PROFILER_FRAME);
+
+		for (uint32_t series = 0; series < PROFILER_SERIES; ++series) {
+			m_history[series * PROFILER_HISTORY + m_next] = m_current[series];
+		}
+
+		m_next = (m_next + 1) % PROFILER_HISTORY;
+		m_frames = std::min(m_frames + 1, PROFILER_HISTORY);
+	}
+
+	void frame_profiler::begin(uint32_t stage) {
+		m_started[stage] = std::chrono::steady_clock::now();
+	}
+
+	void frame_profiler::end(uint32_t stage) {
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_started[stage];
+		m_current[stage] += elapsed.count();
+	}
+
+	void frame_profiler::add(uint32_t series, float value) {
+		m_current[series] += value;
+	}
+
+	frame_profiler::frame_profiler() :
+		m_history(PROFILER_SERIES * PROFILER_HISTORY, 0.0f),
+		m_next(0),
+		m_frames(0) {
+
+		m_current.fill(0.0f);
+		m_started.fill(std::chrono::steady_clock::now());
+	}
+}
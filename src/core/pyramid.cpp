@@ -0,0 +1,79 @@
+#include "pyramid.hpp"
+#include <algorithm>
+
+namespace mini {
+	uint32_t height_pyramid::get_level_count() const {
+		return static_cast<uint32_t>(m_levels.size());
+	}
+
+	std::size_t height_pyramid::get_memory_bytes() const {
+		std::size_t bytes = m_levels.capacity() * sizeof(level_t);
+
+		for (const auto& level : m_levels) {
+			bytes += (level.min.capacity() + level.max.capacity()) * sizeof(float);
+		}
+
+		return bytes;
+	}
+
+	void height_pyramid::reset(uint32_t tiles_x, uint32_t tiles_y, float min, float max) {
+		m_levels.clear();
+
+		uint32_t width = std::max(tiles_x, 1u);
+		uint32_t height = std::max(tiles_y, 1u);
+
+		while (true) {
+			level_t level;
+			level.width = width;
+			level.height = height;
+			level.min.assign(static_cast<std::size_t>(width) * height, min);
+			level.max.assign(static_cast<std::size_t>(width) * height, max);
+
+			m_levels.push_back(std::move(level));
+
+			if (width == 1 && height == 1) {
+				break;
+			}
+
+			width = (width + 1) >> 1;
+			height = (height + 1) >> 1;
+		}
+	}
+
+	void height_pyramid::rebuild() {
+		for (std::size_t k = 1; k < m_levels.size(); ++k) {
+			const level_t& fine = m_levels[k - 1];
+			level_t& coarse = m_levels[k];
+
+			for (uint32_t y = 0; y < coarse.height; ++y) {
+				for (uint32_t x = 0; x < coarse.width; ++x) {
+					uint32_t x0 = x << 1, x1 = std::min(x0 + 1, fine.width - 1);
+					uint32_t y0 = y << 1, y1 = std::min(y0 + 1, fine.height - 1);
+
+					std::size_t i00 = y0 * fine.width + x0, i01 = y0 * fine.width + x1;
+					std::size_t i10 = y1 * fine.width + x0, i11 = y1 * fine.width + x1;
+
+					coarse.min[y * coarse.width + x] = std::min({ fine.min[i00], fine.min[i01], fine.min[i10], fine.min[i11] });
+					coarse.max[y * coarse.width + x] = std::max({ fine.max[i00], fine.max[i01], fine.max[i10], fine.max[i11] });
+				}
+			}
+		}
+	}
+
+	float height_pyramid::query_max(uint32_t tile_begin_x, uint32_t tile_begin_y, uint32_t tile_end_x, uint32_t tile_end_y) const {
+		uint32_t k = 0;
+
+		while ((tile_end_x >> k) - (tile_begin_x >> k) > 1 || (tile_end_y >> k) - (tile_begin_y >> k) > 1) {
+			++k;
+		}
+
+		const level_t& level = m_levels[k];
+
+		uint32_t x0 = tile_begin_x >> k, x1 = tile_end_x >> k;
+		uint32_t y0 = tile_begin_y >> k, y1 = tile_end_y >> k;
+
+		return std::max(
+			std::max(level.max[y0 * level.width + x0], level.max[y0 * level.width + x1]),
+			std::max(level.max[y1 * level.width + x0], level.max[y1 * level.width + x1]));
+	}
+}
@@ -0,0 +1,593 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+
+#include "toolpath.hpp"
+#include "mapped.hpp"
+#include "memory.hpp"
+#include "parser.hpp"
+#include "trace.hpp"
+
+namespace mini {
+	// caches start with the magic and the version, others are ignored and written over
+	static const char toolpath_cache_magic[8] = { 'M', 'I', 'L', 'L', 'P', 'A', 'T', 'H' };
+	constexpr const uint32_t TOOLPATH_CACHE_VERSION = 3;
+
+	// points are kept in scene units, centimetres with y up, so loading converts nothing
+	constexpr const uint32_t TOOLPATH_CACHE_UNITS_SCENE = 1;
+
+	// followed by the x, the y and then the z coordinates of every point as 32 bit floats, in the
+	// byte order of the machine that wrote it
+	struct toolpath_cache_header_t {
+		char magic[8];
+		uint32_t version;
+		uint32_t units;
+		uint32_t spherical;
+		float radius;
+		float bounds_min[3];
+		float bounds_max[3];
+		uint64_t source_size;
+		uint64_t source_hash;
+		uint64_t point_count;
+	};
+
+	static_assert(sizeof(toolpath_cache_header_t) == 72, "the cache header has to be packed");
+
+	// points load_toolpath converts before adding them to the path at once
+	constexpr const std::size_t TOOLPATH_LOAD_BATCH = 1024;
+
+	// programs are in millimetres with z up, the scene is in centimetres with y up
+	static inline glm::vec3 to_scene(const command_g01_t& command) {
+		return glm::vec3 { -command.x, -command.z, command.y } * 0.1f;
+	}
+
+	static std::optional<std::string> cutter_from_path(const std::string& path) {
+		if (path.size() < 4) {
+			std::cerr << "invalid file name" << std::endl;
+			return std::nullopt;
+		}
+
+		auto ext = path.substr(path.size() - 4);
+		if (ext[0] != '.') {
+			std::cerr << "invalid file name, please use .fXX or .kXX" << std::endl;
+			return std::nullopt;
+		}
+
+		return ext.substr(1);
+	}
+
+	// quiet leaves the messages to whatever reads the program once the cache turns out unusable
+	static bool read_cutter(const std::string& cutter, float& radius, bool& spherical, bool quiet = false) {
+		if (cutter.size() != 3) {
+			if (!quiet) {
+				std::cerr << "invalid cutter \'" << cutter << "\', please use fXX or kXX" << std::endl;
+			}
+
+			return false;
+		}
+
+		if (cutter[0] == 'f') {
+			spherical = false;
+		} else if (cutter[0] == 'k') {
+			spherical = true;
+		} else {
+			if (!quiet) {
+				std::cerr << "invalid cutter name \'" << cutter[0] << "\'" << std::endl;
+			}
+
+			return false;
+		}
+
+		char d0 = cutter[1] - '0';
+		char d1 = cutter[2] - '0';
+
+		if (d0 < 0 || d1 < 0 || d0 > 9 || d1 > 9) {
+			if (!quiet) {
+				std::cerr << "invalid cutter radius \'" << cutter[1] << cutter[2] << "\'" << std::endl;
+			}
+
+			return false;
+		}
+
+		int diameter = d0 * 10 + d1;
+		radius = static_cast<float>(diameter) * 0.1f * 0.5f;
+
+		if (!quiet) {
+			std::cout << "loaded cutter data, is sphere: " << spherical << ", radius: " << diameter << std::endl;
+		}
+
+		return true;
+	}
+
+	static std::shared_ptr<toolpath> read_cache(const std::string& path, float radius, bool spherical) {
+		MINI_TRACE_ZONE("read_toolpath_cache");
+
+		mapped_file cache(path + TOOLPATH_CACHE_EXTENSION);
+		toolpath_cache_header_t header;
+
+		if (!cache.is_open() || cache.get_size() < sizeof(header)) {
+			return nullptr;
+		}
+
+		std::memcpy(&header, cache.get_data(), sizeof(header));
+
+		if (std::memcmp(header.magic, toolpath_cache_magic, sizeof(header.magic)) != 0 ||
+			header.version != TOOLPATH_CACHE_VERSION ||
+			header.units != TOOLPATH_CACHE_UNITS_SCENE ||
+			header.spherical != static_cast<uint32_t>(spherical) ||
+			header.radius != radius ||
+			header.point_count != (cache.get_size() - sizeof(header)) / (3 * sizeof(float)) ||
+			(cache.get_size() - sizeof(header)) % (3 * sizeof(float)) != 0) {
+			return nullptr;
+		}
+
+		mapped_file source(path);
+
+		if (!source.is_open() || source.get_size() != header.source_size) {
+			return nullptr;
+		}
+
+		source_hash hash;
+		hash.update(source.get_data(), source.get_size());
+
+		if (hash.get_value() != header.source_hash) {
+			return nullptr;
+		}
+
+		// the header keeps the coordinates that follow it aligned
+		const float* x = reinterpret_cast<const float*>(cache.get_data() + sizeof(header));
+		const float* y = x + header.point_count;
+		const float* z = y + header.point_count;
+
+		auto points = std::make_shared<toolpath>(radius, spherical);
+		points->append(x, y, z, header.point_count);
+
+		return points;
+	}
+
+	toolpath::toolpath(float radius, bool spherical) :
+		m_radius(radius),
+		m_spherical(spherical) { }
+
+	float toolpath::get_radius() const {
+		return m_radius;
+	}
+
+	bool toolpath::is_spherical() const {
+		return m_spherical;
+	}
+
+	const std::vector<float>& toolpath::get_x() const {
+		return m_x;
+	}
+
+	const std::vector<float>& toolpath::get_y() const {
+		return m_y;
+	}
+
+	const std::vector<float>& toolpath::get_z() const {
+		return m_z;
+	}
+
+	static void axis_bounds(const std::vector<float>& values, float& min, float& max) {
+		min = values[0];
+		max = values[0];
+
+		for (std::size_t i = 1; i < values.size(); ++i) {
+			min = glm::min(min, values[i]);
+			max = glm::max(max, values[i]);
+		}
+	}
+
+	void toolpath::get_bounds(glm::vec3& min, glm::vec3& max) const {
+		if (m_x.empty()) {
+			min = glm::vec3(0.0f);
+			max = glm::vec3(0.0f);
+			return;
+		}
+
+		axis_bounds(m_x, min.x, max.x);
+		axis_bounds(m_y, min.y, max.y);
+		axis_bounds(m_z, min.z, max.z);
+	}
+
+	std::size_t toolpath::get_memory_bytes() const {
+		return memory_bytes(m_x) + memory_bytes(m_y) + memory_bytes(m_z) + memory_bytes(m_distances) +
+			memory_bytes(m_lengths) + memory_bytes(m_vertical);
+	}
+
+	void toolpath::reserve(std::size_t points) {
+		m_x.reserve(points);
+		m_y.reserve(points);
+		m_z.reserve(points);
+		m_distances.reserve(points);
+
+		m_lengths.reserve(points);
+		m_vertical.reserve(points);
+	}
+
+	void toolpath::push_back(const glm::vec3& point) {
+		m_x.push_back(point.x);
+		m_y.push_back(point.y);
+		m_z.push_back(point.z);
+
+		m_update_segments(m_x.size() - 1);
+	}
+
+	void toolpath::append(const std::vector<glm::vec3>& points) {
+		const std::size_t first = m_x.size();
+
+		m_x.resize(first + points.size());
+		m_y.resize(first + points.size());
+		m_z.resize(first + points.size());
+
+		for (std::size_t i = 0; i < points.size(); ++i) {
+			m_x[first + i] = points[i].x;
+			m_y[first + i] = points[i].y;
+			m_z[first + i] = points[i].z;
+		}
+
+		m_update_segments(first);
+	}
+
+	void toolpath::append(const float* x, const float* y, const float* z, std::size_t count) {
+		const std::size_t first = m_x.size();
+
+		m_x.insert(m_x.end(), x, x + count);
+		m_y.insert(m_y.end(), y, y + count);
+		m_z.insert(m_z.end(), z, z + count);
+
+		m_update_segments(first);
+	}
+
+	void toolpath::clear() {
+		m_x.clear();
+		m_y.clear();
+		m_z.clear();
+		m_distances.clear();
+
+		m_lengths.clear();
+		m_vertical.clear();
+	}
+
+	void toolpath::m_update_segments(std::size_t first_point) {
+		const std::size_t count = m_x.size();
+		const std::size_t segments = count > 0 ? count - 1 : 0;
+
+		// the first point of the path ends no segment
+		const std::size_t first = first_point > 0 ? first_point - 1 : 0;
+
+		m_distances.resize(count);
+		m_lengths.resize(segments);
+		m_vertical.resize(segments);
+
+		const float* x = m_x.data();
+		const float* y = m_y.data();
+		const float* z = m_z.data();
+
+		float* lengths = m_lengths.data();
+		uint8_t* vertical = m_vertical.data();
+
+		// every segment only reads its own two points, which lets the loop vectorize. the root is
+		// taken apart, as a call that may set errno keeps the compiler from vectorizing the loop
+		// around it. the length is summed in the same order as glm::distance, so carving steps
+		// exactly as it always has
+		for (std::size_t i = first; i < segments; ++i) {
+			float dx = x[i + 1] - x[i];
+			float dy = y[i + 1] - y[i];
+			float dz = z[i + 1] - z[i];
+
+			lengths[i] = dx * dx + dy * dy + dz * dz;
+			vertical[i] = fabsf(dy) > 0.0001f ? 1 : 0;
+		}
+
+		for (std::size_t i = first; i < segments; ++i) {
+			lengths[i] = sqrtf(lengths[i]);
+		}
+
+		if (first_point == 0 && count > 0) {
+			m_distances[0] = 0.0f;
+		}
+
+		for (std::size_t i = glm::max<std::size_t>(first_point, 1); i < count; ++i) {
+			m_distances[i] = m_distances[i - 1] + lengths[i - 1];
+		}
+	}
+
+	std::shared_ptr<toolpath> load_toolpath(const std::string& path) {
+		auto cutter = cutter_from_path(path);
+
+		if (!cutter) {
+			return nullptr;
+		}
+
+		return load_toolpath(path, cutter.value());
+	}
+
+	static std::shared_ptr<toolpath> load_points(milling_command_parser& parser, float radius, bool spherical) {
+		std::vector<milling_command> commands = parser.get_commands_parallel();
+
+		auto points = std::make_shared<toolpath>(radius, spherical);
+		points->reserve(commands.size());
+
+		std::vector<glm::vec3> batch;
+		batch.reserve(TOOLPATH_LOAD_BATCH);
+
+		for (auto& command : commands) {
+			std::visit([&](const auto& arg) {
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_same_v<T, command_invalid>) {
+					std::cerr << "invalid command detected" << std::endl;
+				} else if constexpr (std::is_same_v<T, command_g01_t>) {
+					batch.push_back(to_scene(arg));
+				}
+			}, command);
+
+			if (batch.size() == TOOLPATH_LOAD_BATCH) {
+				points->append(batch);
+				batch.clear();
+			}
+		}
+
+		points->append(batch);
+		return points;
+	}
+
+	std::shared_ptr<toolpath> load_toolpath(const std::string& path, const std::string& cutter) {
+		float radius;
+		bool spherical;
+
+		if (!read_cutter(cutter, radius, spherical)) {
+			return nullptr;
+		}
+
+		milling_command_parser parser(path);
+		return load_points(parser, radius, spherical);
+	}
+
+	std::shared_ptr<toolpath> read_toolpath_cache(const std::string& path) {
+		if (path.size() < 4 || path[path.size() - 4] != '.') {
+			return nullptr;
+		}
+
+		return read_toolpath_cache(path, path.substr(path.size() - 3));
+	}
+
+	std::shared_ptr<toolpath> read_toolpath_cache(const std::string& path, const std::string& cutter) {
+		float radius;
+		bool spherical;
+
+		if (!read_cutter(cutter, radius, spherical, true)) {
+			return nullptr;
+		}
+
+		return read_cache(path, radius, spherical);
+	}
+
+	bool write_toolpath_cache(const std::string& path, const toolpath& points, const source_hash& source) {
+		MINI_TRACE_ZONE("write_toolpath_cache");
+
+		// nothing was read from a program that could not be opened, there is nothing to keep
+		if (source.get_size() == 0) {
+			return false;
+		}
+
+		toolpath_cache_header_t header = {};
+		std::memcpy(header.magic, toolpath_cache_magic, sizeof(header.magic));
+		header.version = TOOLPATH_CACHE_VERSION;
+		header.units = TOOLPATH_CACHE_UNITS_SCENE;
+		header.spherical = points.is_spherical() ? 1 : 0;
+		header.radius = points.get_radius();
+		header.source_size = source.get_size();
+		header.source_hash = source.get_value();
+		header.point_count = points.get_point_count();
+
+		glm::vec3 min, max;
+		points.get_bounds(min, max);
+
+		for (int axis = 0; axis < 3; ++axis) {
+			header.bounds_min[axis] = min[axis];
+			header.bounds_max[axis] = max[axis];
+		}
+
+		// written next to the cache and moved over it, so a load meanwhile reads the old one whole
+		const std::string cache_path = path + TOOLPATH_CACHE_EXTENSION;
+		const std::string temp_path = cache_path + ".tmp";
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const auto* axis : { &points.get_x(), &points.get_y(), &points.get_z() }) {
+			file.write(reinterpret_cast<const char*>(axis->data()), axis->size() * sizeof(float));
+		}
+
+		file.close();
+
+		std::error_code error;
+
+		if (file) {
+			std::filesystem::rename(temp_path, cache_path, error);
+		}
+
+		if (!file || error) {
+			std::filesystem::remove(temp_path, error);
+			std::cerr << "[WARN] failed to write the toolpath cache " << cache_path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	std::shared_ptr<toolpath> load_toolpath_cached(const std::string& path) {
+		auto cutter = cutter_from_path(path);
+
+		if (!cutter) {
+			return nullptr;
+		}
+
+		return load_toolpath_cached(path, cutter.value());
+	}
+
+	std::shared_ptr<toolpath> load_toolpath_cached(const std::string& path, const std::string& cutter) {
+		auto points = read_toolpath_cache(path, cutter);
+
+		if (points) {
+			std::cout << "[INFO] read " << points->get_point_count() << " points from the cache of " << path << std::endl;
+			return points;
+		}
+
+		float radius;
+		bool spherical;
+
+		if (!read_cutter(cutter, radius, spherical)) {
+			return nullptr;
+		}
+
+		milling_command_parser parser(path);
+		points = load_points(parser, radius, spherical);
+
+		// hashed as parsed, a program changed since then is not cached as if it were unchanged
+		write_toolpath_cache(path, *points, parser.get_source_hash());
+		return points;
+	}
+
+	std::unique_ptr<toolpath_stream> stream_toolpath(const std::string& path) {
+		auto cutter = cutter_from_path(path);
+
+		if (!cutter) {
+			return nullptr;
+		}
+
+		return stream_toolpath(path, cutter.value());
+	}
+
+	std::unique_ptr<toolpath_stream> stream_toolpath(const std::string& path, const std::string& cutter) {
+		float radius;
+		bool spherical;
+
+		if (!read_cutter(cutter, radius, spherical)) {
+			return nullptr;
+		}
+
+		return std::make_unique<toolpath_stream>(path, radius, spherical);
+	}
+
+	toolpath_stream::toolpath_stream(const std::string& path, float radius, bool spherical) :
+		m_queue(TOOLPATH_STREAM_CAPACITY),
+		m_done(false),
+		m_stop(false),
+		m_radius(radius),
+		m_spherical(spherical) {
+
+		m_thread = std::thread(&toolpath_stream::m_parse, this, path);
+	}
+
+	toolpath_stream::~toolpath_stream() {
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mutex);
+			m_stop.store(true, std::memory_order_relaxed);
+		}
+
+		m_cache_requested.notify_one();
+		m_thread.join();
+	}
+
+	float toolpath_stream::get_radius() const {
+		return m_radius;
+	}
+
+	bool toolpath_stream::is_spherical() const {
+		return m_spherical;
+	}
+
+	std::size_t toolpath_stream::take_points(toolpath& path) {
+		m_taken.clear();
+		m_queue.pop_all(m_taken);
+		path.append(m_taken);
+
+		return m_taken.size();
+	}
+
+	bool toolpath_stream::is_finished() const {
+		// the parser pushes its last points before it is done, so once it is the queue only drains
+		return m_done.load(std::memory_order_acquire) && m_queue.is_empty();
+	}
+
+	void toolpath_stream::write_cache(std::shared_ptr<const toolpath> points) {
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mutex);
+			m_cache_points = std::move(points);
+		}
+
+		m_cache_requested.notify_one();
+	}
+
+	void toolpath_stream::m_parse(std::string path) {
+		trace_recorder::get().set_thread_name("parser");
+
+		milling_command_parser parser(path);
+		std::vector<glm::vec3> batch;
+		batch.reserve(TOOLPATH_STREAM_BATCH);
+
+		bool parsing = true;
+
+		// one zone per batch, a zone per line would outnumber the lines of the program in the trace
+		while (parsing && !m_stop.load(std::memory_order_relaxed)) {
+			MINI_TRACE_ZONE("toolpath_stream::m_parse");
+
+			while (batch.size() < TOOLPATH_STREAM_BATCH && !m_stop.load(std::memory_order_relaxed)) {
+				auto command = parser.get_next_command();
+
+				if (!command.has_value()) {
+					parsing = false;
+					break;
+				}
+
+				std::visit([&](const auto& arg) {
+					using T = std::decay_t<decltype(arg)>;
+					if constexpr (std::is_same_v<T, command_invalid>) {
+						std::cerr << "invalid command detected" << std::endl;
+					} else if constexpr (std::is_same_v<T, command_g01_t>) {
+						batch.push_back(to_scene(arg));
+					}
+				}, command.value());
+			}
+
+			m_push(batch);
+			batch.clear();
+		}
+
+		m_done.store(true, std::memory_order_release);
+
+		// the thread stays to write the cache, so whoever takes the points is not held up by it
+		std::unique_lock<std::mutex> lock(m_cache_mutex);
+		m_cache_requested.wait(lock, [this] { return m_cache_points != nullptr || m_stop.load(std::memory_order_relaxed); });
+
+		auto points = std::move(m_cache_points);
+		lock.unlock();
+
+		// a program cut short by stopping the stream is not cached
+		if (points && !parsing) {
+			write_toolpath_cache(path, *points, parser.get_source_hash());
+		}
+	}
+
+	void toolpath_stream::m_push(const std::vector<glm::vec3>& points) {
+		MINI_TRACE_ZONE("toolpath_stream::m_push");
+		std::size_t pushed = 0;
+
+		// a full queue means carving is behind, which takes far longer than a short nap
+		while (pushed < points.size() && !m_stop.load(std::memory_order_relaxed)) {
+			pushed += m_queue.try_push(points.data() + pushed, points.size() - pushed);
+
+			if (pushed < points.size()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+}
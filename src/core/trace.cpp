@@ -0,0 +1,179 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace mini {
+	thread_local trace_recorder::thread_buffer_t* trace_recorder::s_thread_buffer = nullptr;
+
+	uint64_t trace_recorder::now() const {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - m_origin).count());
+	}
+
+	void trace_recorder::start() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// buffers still holding an older capture are left alone, write skips them and their
+		// threads empty them on the next zone they record
+		m_epoch.store(now(), std::memory_order_release);
+		m_enabled.store(true, std::memory_order_release);
+	}
+
+	void trace_recorder::stop() {
+		m_enabled.store(false, std::memory_order_relaxed);
+	}
+
+	bool trace_recorder::write(const std::string& path) const {
+		struct thread_copy_t {
+			uint32_t id;
+			std::string name;
+			std::vector<event_t> events;
+			uint64_t dropped;
+		};
+
+		// threads keep recording while the file is written, so the events each buffer has
+		// published are copied first
+		std::vector<thread_copy_t> threads;
+		uint64_t epoch;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			epoch = m_epoch.load(std::memory_order_acquire);
+			threads.reserve(m_buffers.size());
+
+			for (const auto& buffer : m_buffers) {
+				threads.push_back({ buffer->id, buffer->name, {}, 0 });
+
+				if (buffer->epoch.load(std::memory_order_acquire) != epoch) {
+					continue;
+				}
+
+				std::size_t size = buffer->size.load(std::memory_order_acquire);
+				auto& events = threads.back().events;
+				events.reserve(size);
+
+				for (std::size_t first = 0; first < size; first += TRACE_CHUNK_EVENTS) {
+					const event_t* chunk = buffer->chunks[first / TRACE_CHUNK_EVENTS].get();
+					events.insert(events.end(), chunk, chunk + std::min(size - first, TRACE_CHUNK_EVENTS));
+				}
+
+				threads.back().dropped = buffer->dropped.load(std::memory_order_relaxed);
+			}
+		}
+
+		std::ofstream file(path);
+
+		if (!file) {
+			std::cerr << "[ERROR] failed to open " << path << " for the trace" << std::endl;
+			return false;
+		}
+
+		// timestamps are in microseconds, nanoseconds are kept as decimals
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		std::size_t events = 0;
+		uint64_t dropped = 0;
+		bool first = true;
+
+		for (const auto& thread : threads) {
+			if (!thread.name.empty()) {
+				file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+					<< ",\"args\":{\"name\":\"" << thread.name << "\"}}";
+				first = false;
+			}
+
+			for (const auto& event : thread.events) {
+				file << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"mini\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+					<< thread.id << ",\"ts\":" << (event.begin - epoch) / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+				first = false;
+				events++;
+			}
+
+			dropped += thread.dropped;
+		}
+
+		file << "\n]}\n";
+
+		if (!file) {
+			std::cerr << "[ERROR] failed to write the trace to " << path << std::endl;
+			return false;
+		}
+
+		if (dropped > 0) {
+			std::cerr << "[WARN] " << dropped << " trace events did not fit into the thread buffers" << std::endl;
+		}
+
+		std::cout << "[INFO] wrote " << events << " trace events to " << path << std::endl;
+		return true;
+	}
+
+	void trace_recorder::set_thread_name(const std::string& name) {
+		auto& buffer = m_thread_buffer();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		buffer.name = name;
+	}
+
+	void trace_recorder::record(const char* name, uint64_t begin, uint64_t end) {
+		auto& buffer = m_thread_buffer();
+		uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+
+		// the zone began before the capture it would end up in
+		if (begin < epoch) {
+			return;
+		}
+
+		// a new capture started, the size is reset before the buffer is claimed for it, so write
+		// never sees the events of the last one as part of this one
+		if (buffer.epoch.load(std::memory_order_relaxed) != epoch) {
+			buffer.size.store(0, std::memory_order_relaxed);
+			buffer.dropped.store(0, std::memory_order_relaxed);
+			buffer.epoch.store(epoch, std::memory_order_release);
+		}
+
+		std::size_t size = buffer.size.load(std::memory_order_relaxed);
+
+		if (size >= TRACE_BUFFER_EVENTS) {
+			buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		auto& chunk = buffer.chunks[size / TRACE_CHUNK_EVENTS];
+
+		if (!chunk) {
+			chunk = std::make_unique<event_t[]>(TRACE_CHUNK_EVENTS);
+		}
+
+		chunk[size % TRACE_CHUNK_EVENTS] = { name, begin, end };
+		buffer.size.store(size + 1, std::memory_order_release);
+	}
+
+	trace_recorder::trace_recorder() :
+		m_enabled(false),
+		m_origin(std::chrono::steady_clock::now()),
+		m_epoch(0) { }
+
+	trace_recorder& trace_recorder::get() {
+		static trace_recorder recorder;
+		return recorder;
+	}
+
+	trace_recorder::thread_buffer_t& trace_recorder::m_thread_buffer() {
+		if (!s_thread_buffer) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_buffers.push_back(std::make_unique<thread_buffer_t>());
+			m_buffers.back()->id = static_cast<uint32_t>(m_buffers.size());
+			m_buffers.back()->epoch = 0;
+			m_buffers.back()->size = 0;
+			m_buffers.back()->dropped = 0;
+
+			s_thread_buffer = m_buffers.back().get();
+		}
+
+		return *s_thread_buffer;
+	}
+}
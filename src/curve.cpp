@@ -1,4 +1,5 @@
 #include "curve.hpp"
+#include "memory.hpp"
 
 namespace mini {
     curve::curve(std::shared_ptr<shader_program> line_shader) {
@@ -7,6 +8,8 @@ namespace mini {
         m_vao = 0;
         m_position_buffer = 0;
         m_index_buffer = 0;
+        m_position_capacity = 0;
+        m_index_capacity = 0;
         m_ready = false;
         m_line_width = 2.0f;
 
@@ -22,15 +25,25 @@ namespace mini {
         m_vao = 0;
         m_position_buffer = 0;
         m_index_buffer = 0;
+        m_position_capacity = 0;
+        m_index_capacity = 0;
         m_ready = false;
         m_line_width = 2.0f;
 
         m_color = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-        m_points = points;
+        for (const auto& point : points) {
+            m_positions.insert(m_positions.end(), { point.x, point.y, point.z });
+        }
+
         m_rebuild_buffers();
     }
 
+    curve::~curve() {
+        m_free_buffers();
+        memory_registry::get().release(this);
+    }
+
     float curve::get_line_width() const {
         return m_line_width;
     }
@@ -48,45 +61,74 @@ namespace mini {
     }
 
     void curve::append_position(const glm::vec3& position) {
-        m_points.insert(m_points.end(), position);
-        m_rebuild_buffers();
+        std::size_t first = m_get_point_count();
+
+        m_positions.insert(m_positions.end(), { position.x, position.y, position.z });
+        m_append_buffers(first);
     }
 
     void curve::prepend_position(const glm::vec3& position) {
-        m_points.insert(m_points.begin(), position);
+        m_positions.insert(m_positions.begin(), { position.x, position.y, position.z });
         m_rebuild_buffers();
     }
 
     void curve::append_positions(const std::vector<glm::vec3>& positions) {
-        m_points.insert(m_points.end(), positions.begin(), positions.end());
-        m_rebuild_buffers();
+        std::size_t first = m_get_point_count();
+
+        for (const auto& position : positions) {
+            m_positions.insert(m_positions.end(), { position.x, position.y, position.z });
+        }
+
+        m_append_buffers(first);
+    }
+
+    void curve::append_positions(const toolpath& path, std::size_t first_point) {
+        std::size_t first = m_get_point_count();
+
+        const auto& x = path.get_x();
+        const auto& y = path.get_y();
+        const auto& z = path.get_z();
+
+        for (std::size_t i = first_point; i < path.get_point_count(); ++i) {
+            m_positions.insert(m_positions.end(), { x[i], y[i], z[i] });
+        }
+
+        m_append_buffers(first);
     }
 
     void curve::prepend_positions(const std::vector<glm::vec3>& positions) {
-        m_points.insert(m_points.begin(), positions.begin(), positions.end());
+        std::vector<float> prepended;
+        prepended.reserve(positions.size() * 3);
+
+        for (const auto& position : positions) {
+            prepended.insert(prepended.end(), { position.x, position.y, position.z });
+        }
+
+        m_positions.insert(m_positions.begin(), prepended.begin(), prepended.end());
         m_rebuild_buffers();
     }
 
     void curve::erase_head() {
-        if (m_points.size() == 0) {
+        if (m_positions.size() == 0) {
             return;
         }
 
-        m_points.erase(m_points.begin());
+        m_positions.erase(m_positions.begin(), m_positions.begin() + 3);
         m_rebuild_buffers();
     }
 
     void curve::clear_points() {
-        m_points.clear();
-        m_free_buffers();
+        // the buffers stay around for the next points
+        m_positions.clear();
+        m_rebuild_buffers();
     }
 
     void curve::erase_tail() {
-        if (m_points.size() == 0) {
+        if (m_positions.size() == 0) {
             return;
         }
 
-        m_points.erase(m_points.end() - 1);
+        m_positions.erase(m_positions.end() - 3, m_positions.end());
         m_rebuild_buffers();
     }
 
@@ -119,54 +161,76 @@ namespace mini {
         glBindVertexArray(0);
     };
 
+    std::size_t curve::m_get_point_count() const {
+        return m_positions.size() / 3;
+    }
+
     void curve::m_rebuild_buffers() {
+        m_indices.clear();
+        m_append_buffers(0);
+    }
+
+    void curve::m_append_buffers(std::size_t first_point) {
         constexpr GLuint a_position = 0;
-        constexpr GLuint a_color = 1;
 
-        if (m_ready) {
-            m_free_buffers();
+        if (m_positions.size() == 0) {
+            m_ready = false;
+            m_report_memory();
+            return;
         }
 
-        m_ready = false;
+        // only the points from first_point on are new, everything before is already in the buffers
+        std::size_t first_position = first_point * 3;
+        std::size_t first_index = m_indices.size();
 
-        if (m_points.size() == 0) {
-            return;
+        for (std::size_t i = first_point; i < m_get_point_count(); ++i) {
+            if (i > 0) {
+                m_indices.push_back(static_cast<uint32_t>(i - 1));
+                m_indices.push_back(static_cast<uint32_t>(i));
+            }
         }
 
-        m_positions.clear();
-        m_positions.resize(m_points.size() * 3);
+        // the gpu buffers are made once and grow like the vectors, so appending a point only sends that point
+        if (!m_vao) {
+            glGenVertexArrays(1, &m_vao);
+            glGenBuffers(1, &m_position_buffer);
+            glGenBuffers(1, &m_index_buffer);
 
-        for (int i = 0; i < m_points.size(); ++i) {
-            m_positions[3 * i + 0] = m_points[i].x;
-            m_positions[3 * i + 1] = m_points[i].y;
-            m_positions[3 * i + 2] = m_points[i].z;
-        }
+            glBindVertexArray(m_vao);
 
-        m_indices.clear();
-        m_indices.reserve(m_points.size() * 2);
+            glBindBuffer(GL_ARRAY_BUFFER, m_position_buffer);
+            glVertexAttribPointer(a_position, 3, GL_FLOAT, false, sizeof(float) * 3, (void*)0);
+            glEnableVertexAttribArray(a_position);
 
-        for (uint32_t i = 0; i < m_points.size() - 1; ++i) {
-            m_indices.push_back(i);
-            m_indices.push_back(i + 1);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+        } else {
+            glBindVertexArray(m_vao);
+            glBindBuffer(GL_ARRAY_BUFFER, m_position_buffer);
         }
 
-        // allocate gpu buffers
-        glGenVertexArrays(1, &m_vao);
-        glGenBuffers(1, &m_position_buffer);
-        glGenBuffers(1, &m_index_buffer);
+        if (m_positions.capacity() > m_position_capacity) {
+            m_position_capacity = m_positions.capacity();
+            first_position = 0;
 
-        glBindVertexArray(m_vao);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * m_position_capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, m_position_buffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * m_positions.size(), reinterpret_cast<void*> (m_positions.data()), GL_STATIC_DRAW);
-        glVertexAttribPointer(a_position, 3, GL_FLOAT, false, sizeof(float) * 3, (void*)0);
-        glEnableVertexAttribArray(a_position);
+        if (m_indices.capacity() > m_index_capacity) {
+            m_index_capacity = m_indices.capacity();
+            first_index = 0;
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * m_index_capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * first_position,
+            sizeof(float) * (m_positions.size() - first_position), m_positions.data() + first_position);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * first_index,
+            sizeof(GLuint) * (m_indices.size() - first_index), m_indices.data() + first_index);
 
         glBindVertexArray(0);
         m_ready = true;
+
+        m_report_memory();
     }
 
     void curve::m_free_buffers() {
@@ -186,5 +250,17 @@ namespace mini {
             glDeleteBuffers(1, &m_index_buffer);
             m_index_buffer = 0;
         }
+
+        m_position_capacity = 0;
+        m_index_capacity = 0;
+
+        m_report_memory();
+    }
+
+    void curve::m_report_memory() const {
+        uint64_t host = memory_bytes(m_positions) + memory_bytes(m_indices);
+        uint64_t gpu = m_position_capacity * sizeof(float) + m_index_capacity * sizeof(GLuint);
+
+        memory_registry::get().report(this, "path", host, gpu);
     }
 }
@@ -1,11 +1,25 @@
+#include <cstring>
 #include <iostream>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "app.hpp"
+#include "trace.hpp"
 
 int main(int argc, char** argv) {
+	// --trace <file> captures the whole session and writes it out on exit
+	std::string trace_path;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+			trace_path = argv[++i];
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--trace <file>]" << std::endl;
+			return 1;
+		}
+	}
+
 	// initialize glfw
 	if (!glfwInit()) {
 		std::cerr << "fatal: failed to initialize glfw!" << std::endl;
@@ -21,8 +35,20 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
+	auto& recorder = mini::trace_recorder::get();
+	recorder.set_thread_name("main");
+
+	if (!trace_path.empty()) {
+		recorder.start();
+	}
+
 	app->message_loop();
 
+	if (!trace_path.empty()) {
+		recorder.stop();
+		recorder.write(trace_path);
+	}
+
 	// cleanup glfw
 	glfwTerminate();
 	return 0;
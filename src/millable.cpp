@@ -1,23 +1,8 @@
 #include "millable.hpp"
-#include <iostream>
+#include "memory.hpp"
+#include "trace.hpp"
 
 namespace mini {
-	uint32_t millable_block::get_heightmap_width() const {
-		return m_heightmap_width;
-	}
-
-	uint32_t millable_block::get_heightmap_height() const {
-		return m_heightmap_height;
-	}
-
-	uint32_t millable_block::get_block_width() const {
-		return m_block_width;
-	}
-
-	uint32_t millable_block::get_block_height() const {
-		return m_block_height;
-	}
-
 	bool millable_block::carve(
 		const milling_mask_t& mask, 
 		int32_t offset_x, 
@@ -25,182 +10,114 @@ namespace mini {
 		float depth, 
 		float max_height) {
 
-		std::vector<float> subdata;
-
-		int32_t start_offset_x = 0;
-		int32_t start_offset_y = 0;
-		int32_t end_offset_x = 0;
-		int32_t end_offset_y = 0;
-
-		if (offset_x < 0) {
-			start_offset_x = -offset_x;
-		}
-		
-		if (offset_x + mask.width >= m_heightmap_width) {
-			end_offset_x = mask.width - (m_heightmap_width - offset_x);
-		}
-
-		if (offset_y < 0) {
-			start_offset_y = -offset_y;
-		}
-
-		if (offset_y + mask.height >= m_heightmap_height) {
-			end_offset_y = mask.height - (m_heightmap_height - offset_y);
-		}
+		millable_block::milling_result_t result;
+		carve_silent(mask, offset_x, offset_y, depth, max_height, result);
 
-		int32_t subdata_width = mask.width - start_offset_x - end_offset_x;
-		int32_t subdata_height = mask.height - start_offset_y - end_offset_y;
+		refresh_texture();
 
-		// out of bounds
-		if (subdata_width * subdata_height < 0) {
-			return true;
-		}
-
-		subdata.resize(subdata_width * subdata_height);
+		return true;
+	}
 
-		for (int32_t cx = 0; cx < subdata_width; ++cx) {
-			for (int32_t cy = 0; cy < subdata_height; ++cy) {
-				int32_t rx = start_offset_x + cx;
-				int32_t ry = start_offset_y + cy;
+	std::size_t millable_block::refresh_texture() {
+		MINI_TRACE_ZONE("millable_block::refresh_texture");
 
-				std::size_t subdata_index = subdata_width * cy + cx;
-				std::size_t mask_index = mask.width * ry + rx;
-				std::size_t hm_index = m_heightmap_width * (ry + offset_y) + rx + offset_x;
+		std::size_t bytes = 0;
+		update_bounds();
 
-				float mask_val = mask.mask[mask_index];
-				float hm_val = m_heightmap[hm_index];
+		if (m_texture) {
+			// only the tiles carved since the last refresh are sent to the gpu
+			glBindTexture(GL_TEXTURE_2D, m_texture);
 
-				if (mask_val - depth < hm_val) {
-					subdata[subdata_index] = glm::max(mask_val - depth, 0.0f);
-					m_heightmap[hm_index] = subdata[subdata_index];
-				} else {
-					subdata[subdata_index] = m_heightmap[hm_index];
+			for (uint32_t ty = 0; ty < get_tiles_y(); ++ty) {
+				for (uint32_t tx = 0; tx < get_tiles_x(); ++tx) {
+					if (!is_tile_dirty(tx, ty)) {
+						continue;
+					}
+
+					uint32_t x = tx << HEIGHTMAP_TILE_SHIFT;
+					uint32_t y = ty << HEIGHTMAP_TILE_SHIFT;
+					uint32_t width = glm::min(HEIGHTMAP_TILE_SIZE, get_heightmap_width() - x);
+					uint32_t height = glm::min(HEIGHTMAP_TILE_SIZE, get_heightmap_height() - y);
+
+					if (is_quantized()) {
+						m_upload_ring->upload(x, y, width, height, GL_RED, GL_UNSIGNED_SHORT, sizeof(uint16_t),
+							get_heightmap16().get_tile(tx, ty), HEIGHTMAP_TILE_SIZE * sizeof(uint16_t));
+						bytes += width * height * sizeof(uint16_t);
+					} else {
+						m_upload_ring->upload(x, y, width, height, GL_RED, GL_FLOAT, sizeof(float),
+							get_heightmap().get_tile(tx, ty), HEIGHTMAP_TILE_SIZE * sizeof(float));
+						bytes += width * height * sizeof(float);
+					}
 				}
 			}
-		}
-
-		if (m_texture) {
-			glBindTexture(GL_TEXTURE_2D, m_texture);
-			glTexSubImage2D(
-				GL_TEXTURE_2D,
-				0,
-				offset_x + start_offset_x,
-				offset_y + start_offset_y,
-				subdata_width,
-				subdata_height,
-				GL_RED,
-				GL_FLOAT,
-				subdata.data());
 
+			m_upload_ring->flush();
 			glBindTexture(GL_TEXTURE_2D, 0);
 		}
 
-		return true;
-	}
-
-	void millable_block::carve_silent(
-		const milling_mask_t& mask, 
-		int32_t offset_x, 
-		int32_t offset_y, 
-		float depth, 
-		float max_height,
-		millable_block::milling_result_t& result) {
-
-		int32_t start_offset_x = 0;
-		int32_t start_offset_y = 0;
-		int32_t end_offset_x = 0;
-		int32_t end_offset_y = 0;
-
-		if (offset_x < 0) {
-			start_offset_x = -offset_x;
-		}
-
-		if (offset_x + mask.width >= m_heightmap_width) {
-			end_offset_x = mask.width - (m_heightmap_width - offset_x);
-		}
-
-		if (offset_y < 0) {
-			start_offset_y = -offset_y;
-		}
-
-		if (offset_y + mask.height >= m_heightmap_height) {
-			end_offset_y = mask.height - (m_heightmap_height - offset_y);
-		}
-
-		int32_t subdata_width = mask.width - start_offset_x - end_offset_x;
-		int32_t subdata_height = mask.height - start_offset_y - end_offset_y;
-
-		// out of bounds
-		if (subdata_width * subdata_height < 0 || subdata_width > mask.width || subdata_height > mask.height) {
-			return;
-		}
-
-		bool collides = false;
-
-		for (int32_t cx = 0; cx < subdata_width; ++cx) {
-			for (int32_t cy = 0; cy < subdata_height; ++cy) {
-				int32_t rx = start_offset_x + cx;
-				int32_t ry = start_offset_y + cy;
-
-				std::size_t subdata_index = subdata_width * cy + cx;
-				std::size_t mask_index = mask.width * ry + rx;
-				std::size_t hm_index = m_heightmap_width * (ry + offset_y) + rx + offset_x;
-
-				float mask_val = mask.mask[mask_index];
-				float hm_val = m_heightmap[hm_index];
-
-				if (mask_val - depth + max_height < hm_val) {
-					result.collision_error = true;
+		// write counts change exactly where the heights do, the texture goes once counting stops
+		if (is_counting_writes() && m_upload_ring) {
+			const auto& writes = get_write_counts();
+
+			if (!m_write_texture) {
+				m_init_write_texture();
+				m_report_memory();
+				bytes += writes.size() * sizeof(uint32_t);
+			} else {
+				glBindTexture(GL_TEXTURE_2D, m_write_texture);
+
+				for (uint32_t ty = 0; ty < get_tiles_y(); ++ty) {
+					for (uint32_t tx = 0; tx < get_tiles_x(); ++tx) {
+						if (!is_tile_dirty(tx, ty)) {
+							continue;
+						}
+
+						uint32_t x = tx << HEIGHTMAP_TILE_SHIFT;
+						uint32_t y = ty << HEIGHTMAP_TILE_SHIFT;
+						uint32_t width = glm::min(HEIGHTMAP_TILE_SIZE, get_heightmap_width() - x);
+						uint32_t height = glm::min(HEIGHTMAP_TILE_SIZE, get_heightmap_height() - y);
+
+						m_upload_ring->upload(x, y, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, sizeof(uint32_t),
+							writes.data() + static_cast<std::size_t>(y) * get_heightmap_width() + x, get_heightmap_width() * sizeof(uint32_t));
+						bytes += width * height * sizeof(uint32_t);
+					}
 				}
 
-				if (mask_val - depth < hm_val) {
-					m_heightmap[hm_index] = glm::max(mask_val - depth, 0.0f);
-
-					result.depth_error = result.depth_error || (m_heightmap[hm_index] < m_min_height);
-					result.was_milled = true;
-				}
+				m_upload_ring->flush();
+				glBindTexture(GL_TEXTURE_2D, 0);
 			}
-		}
-	}
+		} else if (m_write_texture) {
+			glDeleteTextures(1, &m_write_texture);
+			m_write_texture = 0;
 
-	void millable_block::refresh_texture() {
-		if (m_texture) {
-			glBindTexture(GL_TEXTURE_2D, m_texture);
-			glTexSubImage2D(
-				GL_TEXTURE_2D,
-				0, 0, 0, m_heightmap_width, m_heightmap_height,
-				GL_RED,
-				GL_FLOAT,
-				m_heightmap.data());
-
-			glBindTexture(GL_TEXTURE_2D, 0);
+			m_report_memory();
 		}
-	}
 
-	void millable_block::set_block_dimensions(uint32_t width, uint32_t height) {
-		m_block_width = width;
-		m_block_height = height;
-		m_heightmap_width = width;
-		m_heightmap_height = height;
+		clear_dirty_tiles();
+		return bytes;
+	}
 
-		m_free_buffers();
-		m_init_buffers();
+	bool millable_block::is_write_overlay() const {
+		return m_write_overlay;
 	}
 
-	void millable_block::set_block_size(const glm::vec3& scale) {
-		m_block_dimensions = scale;
+	float millable_block::get_write_overlay_scale() const {
+		return m_write_overlay_scale;
 	}
 
-	void millable_block::set_block_position(const glm::vec3& position) {
-		m_block_translation = position;
+	void millable_block::set_write_overlay(bool overlay) {
+		m_write_overlay = overlay;
 	}
 
-	const glm::vec3& millable_block::get_block_size() const {
-		return m_block_dimensions;
+	void millable_block::set_write_overlay_scale(float scale) {
+		m_write_overlay_scale = glm::max(scale, 1.0f);
 	}
 
-	const glm::vec3& millable_block::get_block_position() const {
-		return m_block_translation;
+	void millable_block::set_block_dimensions(uint32_t width, uint32_t height) {
+		milling_block::set_block_dimensions(width, height);
+
+		m_free_buffers();
+		m_init_buffers();
 	}
 
 	millable_block::millable_block(
@@ -208,31 +125,30 @@ namespace mini {
 		std::shared_ptr<shader_program> wall_shader, 
 		uint32_t width, 
 		uint32_t height,
-		float min_height) :
+		float min_height,
+		bool quantized) :
 
+		milling_block(width, height, min_height, quantized),
 		m_vao(0), 
-		m_buffer_index(0), 
-		m_buffer_position(0),
 		m_texture(0),
+		m_write_texture(0),
+		m_write_overlay(false),
+		m_write_overlay_scale(16.0f),
+		m_buffer_position(0),
+		m_buffer_index(0), 
 		m_vao_w(0),
 		m_buffer_position_w(0),
 		m_buffer_index_w(0),
 		m_buffer_normal_w(0),
-		m_heightmap_width(width),
-		m_heightmap_height(height),
-		m_block_width(width),
-		m_block_height(height),
 		m_block_shader(shader),
-		m_wall_shader(wall_shader),
-		m_block_dimensions(1.0f),
-		m_block_translation(0.0f),
-		m_min_height(min_height) {
+		m_wall_shader(wall_shader) {
 
 		m_init_buffers();
 	}
 
 	millable_block::~millable_block() {
 		m_free_buffers();
+		memory_registry::get().release(this);
 	}
 
 	void millable_block::render(app_context& context, const glm::mat4x4& world_matrix) const {
@@ -256,8 +172,25 @@ namespace mini {
 		shader.set_uniform("u_surface_color", glm::vec3{ 1.0f, 1.0f, 1.0f });
 		shader.set_uniform("u_shininess", 3.0f);
 
+		// the counts are integers, samplers of different types may never share a texture unit
+		bool overlay = m_write_overlay && m_write_texture;
+		shader.set_uniform_sampler("u_writes", 1);
+		shader.set_uniform_int("u_overlay", overlay ? 1 : 0);
+
+		if (overlay) {
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, m_write_texture);
+
+			shader.set_uniform("u_overlay_scale", m_write_overlay_scale);
+		}
+
 		glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
 
+		if (overlay) {
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glActiveTexture(GL_TEXTURE0);
+		}
+
 		glBindVertexArray(0);
 
 		/// WALLS
@@ -282,9 +215,6 @@ namespace mini {
 	}
 
 	void millable_block::m_init_buffers() {
-		m_heightmap.resize(m_heightmap_width * m_heightmap_height);
-		std::fill(m_heightmap.begin(), m_heightmap.end(), 1.0f);
-
 		// init texture
 		glGenTextures(1, &m_texture);
 		glBindTexture(GL_TEXTURE_2D, m_texture);
@@ -294,7 +224,22 @@ namespace mini {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_heightmap_width, m_heightmap_height, 0, GL_RED, GL_FLOAT, m_heightmap.data());
+		if (is_quantized()) {
+			std::vector<uint16_t> data;
+			get_heightmap16().read(data);
+
+			// rows of 16 bit texels are not necessarily 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, get_heightmap_width(), get_heightmap_height(), 0, GL_RED, GL_UNSIGNED_SHORT, data.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		} else {
+			std::vector<float> data;
+			get_heightmap().read(data);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, get_heightmap_width(), get_heightmap_height(), 0, GL_RED, GL_FLOAT, data.data());
+		}
+
+		m_upload_ring = std::make_unique<pixel_upload_ring>(MILLING_UPLOAD_SEGMENT_SIZE, MILLING_UPLOAD_SEGMENTS);
 
 		glGenVertexArrays(1, &m_vao);
 		glBindVertexArray(m_vao);
@@ -303,16 +248,16 @@ namespace mini {
 		glGenBuffers(1, &m_buffer_index);
 
 		// use tesselation instead of this?
-		const uint32_t num_points_x = m_block_width + 1;
-		const uint32_t num_points_y = m_block_height + 1;
+		const uint32_t num_points_x = get_block_width() + 1;
+		const uint32_t num_points_y = get_block_height() + 1;
 
-		const float step_x = 1.0f / static_cast<float>(m_block_width);
-		const float step_y = 1.0f / static_cast<float>(m_block_height);
+		const float step_x = 1.0f / static_cast<float>(get_block_width());
+		const float step_y = 1.0f / static_cast<float>(get_block_height());
 
 		m_positions.reserve(num_points_x * num_points_y * 3);
 
-		for (auto px = 0; px < num_points_x; ++px) {
-			for (auto py = 0; py < num_points_y; ++py) {
+		for (uint32_t px = 0; px < num_points_x; ++px) {
+			for (uint32_t py = 0; py < num_points_y; ++py) {
 				float pos_x = step_x * px - 0.5f;
 				float pos_y = 0.0f;
 				float pos_z = step_y * py - 0.5f;
@@ -325,10 +270,10 @@ namespace mini {
 
 		// prepare indices
 		// 6 indices per quad
-		m_indices.reserve(m_block_width * m_block_height * 6);
+		m_indices.reserve(get_block_width() * get_block_height() * 6);
 
-		for (auto px = 0; px < m_block_width; ++px) {
-			for (auto py = 0; py < m_block_height; ++py) {
+		for (uint32_t px = 0; px < get_block_width(); ++px) {
+			for (uint32_t py = 0; py < get_block_height(); ++py) {
 				auto lt = py * num_points_x + px;
 				auto lb = (py + 1) * num_points_x + px;
 				auto rt = py * num_points_x + px + 1;
@@ -355,6 +300,7 @@ namespace mini {
 		glBindVertexArray(0);
 
 		m_init_wall_buffers();
+		m_report_memory();
 	}
 
 	void millable_block::m_init_wall_buffers() {
@@ -365,11 +311,11 @@ namespace mini {
 		glGenBuffers(1, &m_buffer_index_w);
 		glGenBuffers(1, &m_buffer_normal_w);
 
-		const uint32_t num_points_x = m_block_width + 1;
-		const uint32_t num_points_y = m_block_height + 1;
+		const uint32_t num_points_x = get_block_width() + 1;
+		const uint32_t num_points_y = get_block_height() + 1;
 
-		const float step_x = 1.0f / static_cast<float>(m_block_width);
-		const float step_y = 1.0f / static_cast<float>(m_block_height);
+		const float step_x = 1.0f / static_cast<float>(get_block_width());
+		const float step_y = 1.0f / static_cast<float>(get_block_height());
 
 		m_positions_w.reserve((2 * num_points_x + 2 * num_points_y) * 6);
 		m_normals_w.reserve((2 * num_points_x + 2 * num_points_y) * 6);
@@ -468,11 +414,33 @@ namespace mini {
 		glBindVertexArray(0);
 	}
 
+	void millable_block::m_init_write_texture() {
+		glGenTextures(1, &m_write_texture);
+		glBindTexture(GL_TEXTURE_2D, m_write_texture);
+
+		// integer textures cannot be filtered
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, get_heightmap_width(), get_heightmap_height(), 0,
+			GL_RED_INTEGER, GL_UNSIGNED_INT, get_write_counts().data());
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
 	void millable_block::m_free_buffers() {
+		m_upload_ring.reset();
+
 		if (m_texture) {
 			glDeleteTextures(1, &m_texture);
 		}
 
+		if (m_write_texture) {
+			glDeleteTextures(1, &m_write_texture);
+		}
+
 		if (m_vao) {
 			glDeleteVertexArrays(1, &m_vao);
 		}
@@ -501,7 +469,34 @@ namespace mini {
 			glDeleteBuffers(1, &m_buffer_normal_w);
 		}
 
-		m_vao = m_buffer_index = m_buffer_position = m_texture = 0;
+		m_vao = m_buffer_index = m_buffer_position = m_texture = m_write_texture = 0;
 		m_vao_w = m_buffer_index_w = m_buffer_position_w = m_buffer_normal_w = 0;
+
+		// the meshes are built again from scratch, keeping them would double them on every resize
+		m_positions.clear();
+		m_indices.clear();
+		m_positions_w.clear();
+		m_normals_w.clear();
+		m_indices_w.clear();
+
+		m_report_memory();
+	}
+
+	void millable_block::m_report_memory() const {
+		auto& registry = memory_registry::get();
+
+		// gpu buffers hold exactly the elements of the meshes, textures their texels
+		uint64_t texels = static_cast<uint64_t>(get_heightmap_width()) * get_heightmap_height();
+		uint64_t textures = m_texture ? texels * (is_quantized() ? sizeof(uint16_t) : sizeof(float)) : 0;
+
+		if (m_write_texture) {
+			textures += texels * sizeof(uint32_t);
+		}
+
+		registry.report(this, "block/textures", 0, textures);
+		registry.report(this, "block/mesh", memory_bytes(m_positions) + memory_bytes(m_indices),
+			m_positions.size() * sizeof(float) + m_indices.size() * sizeof(uint32_t));
+		registry.report(this, "block/walls", memory_bytes(m_positions_w) + memory_bytes(m_normals_w) + memory_bytes(m_indices_w),
+			(m_positions_w.size() + m_normals_w.size()) * sizeof(float) + m_indices_w.size() * sizeof(uint32_t));
 	}
 }
\ No newline at end of file
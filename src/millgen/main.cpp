@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// writes synthetic milling programs in the format the parser reads, many times longer than the
+// bundled ones, for stress testing the parser, the carving and the path rendering
+
+struct generator_settings_t {
+	std::string pattern;
+	std::string tool;
+	std::string output;
+
+	uint64_t lines;
+	uint32_t seed;
+
+	// block in millimetres, centered on the origin with its bottom at zero height
+	float size_x;
+	float size_y;
+	float height;
+	float min_height;
+};
+
+static void print_usage() {
+	std::cout <<
+		"usage: millgen [options]\n"
+		"  --pattern <name>       raster, spiral, plunge or finish, raster by default\n"
+		"  --lines <n>            commands to write, the program ends with a few more to\n"
+		"                         lift the cutter, 100000 by default\n"
+		"  --seed <n>             seed of the random patterns, 1 by default\n"
+		"  --tool <kXX|fXX>       cutter the program is meant for, becomes the file extension,\n"
+		"                         k08 by default\n"
+		"  --size <x> <y> <z>     block size in centimetres, 18 5 18 by default\n"
+		"  --min-height <h>       cuts stay above this height in centimetres, 1 by default\n"
+		"  --output <name>        file name without the extension, generated by default\n"
+		"\n"
+		"patterns:\n"
+		"  raster                 zig-zag rows at half the block height\n"
+		"  spiral                 spiral ramping down from the edge of the block to its center\n"
+		"  plunge                 straight plunges to random depths, three commands each\n"
+		"  finish                 dense zig-zag following a random smooth surface\n";
+}
+
+// numbers the commands and formats them the way the parser wants them, three decimals
+class program_writer_t {
+	private:
+		FILE* m_file;
+		uint64_t m_lines;
+		std::vector<char> m_buffer;
+
+		float m_x, m_y;
+
+	public:
+		uint64_t get_lines() const {
+			return m_lines;
+		}
+
+		bool is_open() const {
+			return m_file != nullptr;
+		}
+
+		void move(float x, float y, float z) {
+			fprintf(m_file, "N%lluG01X%.3fY%.3fZ%.3f\n", static_cast<unsigned long long>(m_lines + 1), x, y, z);
+			m_lines++;
+			m_x = x;
+			m_y = y;
+		}
+
+		// straight up or down from where the cutter is
+		void lift(float z) {
+			move(m_x, m_y, z);
+		}
+
+		bool close() {
+			if (!m_file) {
+				return false;
+			}
+
+			bool good = !ferror(m_file);
+			good = fclose(m_file) == 0 && good;
+			m_file = nullptr;
+
+			return good;
+		}
+
+		explicit program_writer_t(const std::string& path) : m_file(fopen(path.c_str(), "w")), m_lines(0), m_buffer(1 << 20), m_x(0.0f), m_y(0.0f) {
+			if (m_file) {
+				setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+			}
+		}
+
+		~program_writer_t() {
+			close();
+		}
+
+		program_writer_t(const program_writer_t&) = delete;
+		program_writer_t& operator=(const program_writer_t&) = delete;
+};
+
+// std distributions differ between standard libraries, the engine itself does not, so the
+// same seed gives the same program everywhere
+class program_random_t {
+	private:
+		std::mt19937 m_engine;
+
+	public:
+		float next(float min, float max) {
+			return min + (max - min) * static_cast<float>(m_engine() / 4294967296.0);
+		}
+
+		explicit program_random_t(uint32_t seed) : m_engine(seed) { }
+};
+
+static float safe_height(const generator_settings_t& settings) {
+	return settings.height + 16.0f;
+}
+
+// rows and points per row for zig-zags of about the given number of commands
+static void zigzag_layout(uint64_t lines, uint64_t& rows, uint64_t& points) {
+	rows = std::max<uint64_t>(2, static_cast<uint64_t>(sqrt(static_cast<double>(lines))));
+	points = std::max<uint64_t>(2, lines / rows);
+}
+
+template <typename F> static void write_zigzag(const generator_settings_t& settings, program_writer_t& writer, F surface) {
+	uint64_t rows, points;
+	zigzag_layout(settings.lines, rows, points);
+
+	const float half_x = settings.size_x * 0.5f;
+	const float half_y = settings.size_y * 0.5f;
+
+	writer.move(-half_x, -half_y, safe_height(settings));
+
+	for (uint64_t row = 0; row < rows; ++row) {
+		float y = -half_y + settings.size_y * row / (rows - 1);
+
+		for (uint64_t point = 0; point < points; ++point) {
+			// every other row goes back the other way
+			uint64_t column = row % 2 == 0 ? point : points - 1 - point;
+			float x = -half_x + settings.size_x * column / (points - 1);
+
+			writer.move(x, y, surface(x, y));
+		}
+	}
+}
+
+static void write_raster(const generator_settings_t& settings, program_writer_t& writer) {
+	const float depth = (settings.height + settings.min_height) * 0.5f;
+
+	write_zigzag(settings, writer, [&](float, float) {
+		return depth;
+	});
+}
+
+static void write_finish(const generator_settings_t& settings, program_writer_t& writer) {
+	program_random_t random(settings.seed);
+
+	struct bump_t {
+		float x, y, radius, height;
+	};
+
+	// a few wide bumps and dips over a tilted plane, smooth enough for a ball end to follow
+	std::vector<bump_t> bumps(8);
+
+	for (auto& bump : bumps) {
+		bump.x = random.next(-0.5f, 0.5f) * settings.size_x;
+		bump.y = random.next(-0.5f, 0.5f) * settings.size_y;
+		bump.radius = random.next(0.1f, 0.3f) * std::min(settings.size_x, settings.size_y);
+		bump.height = random.next(-0.25f, 0.25f);
+	}
+
+	const float range = settings.height - settings.min_height;
+	const float base = settings.min_height + range * 0.5f;
+
+	write_zigzag(settings, writer, [&](float x, float y) {
+		float z = base + range * 0.1f * (x / settings.size_x + y / settings.size_y);
+
+		for (const auto& bump : bumps) {
+			float dx = x - bump.x, dy = y - bump.y;
+			z += range * bump.height * expf(-(dx * dx + dy * dy) / (bump.radius * bump.radius));
+		}
+
+		return std::clamp(z, settings.min_height, settings.height);
+	});
+}
+
+static void write_spiral(const generator_settings_t& settings, program_writer_t& writer) {
+	const uint64_t points = std::max<uint64_t>(2, settings.lines);
+	const double turns = std::max(1.0, sqrt(static_cast<double>(points)) / 8.0);
+
+	const double pi2 = 6.283185307179586;
+	const float outer = std::min(settings.size_x, settings.size_y) * 0.5f;
+	const float top = settings.height;
+	const float bottom = (settings.height + settings.min_height) * 0.5f;
+
+	writer.move(outer, 0.0f, safe_height(settings));
+
+	for (uint64_t point = 0; point < points; ++point) {
+		double t = static_cast<double>(point) / (points - 1);
+		double angle = pi2 * turns * t;
+		float radius = outer * static_cast<float>(1.0 - t);
+
+		writer.move(
+			radius * static_cast<float>(cos(angle)),
+			radius * static_cast<float>(sin(angle)),
+			top + (bottom - top) * static_cast<float>(t));
+	}
+}
+
+static void write_plunge(const generator_settings_t& settings, program_writer_t& writer) {
+	program_random_t random(settings.seed);
+
+	const float half_x = settings.size_x * 0.5f;
+	const float half_y = settings.size_y * 0.5f;
+	const float safe = safe_height(settings);
+
+	writer.move(0.0f, 0.0f, safe);
+
+	while (writer.get_lines() < settings.lines) {
+		float x = random.next(-half_x, half_x);
+		float y = random.next(-half_y, half_y);
+		float z = random.next(settings.min_height, settings.height);
+
+		writer.move(x, y, safe);
+		writer.move(x, y, z);
+		writer.move(x, y, safe);
+	}
+}
+
+int main(int argc, char** argv) {
+	generator_settings_t settings = { "raster", "k08", "generated", 100000, 1, 180.0f, 180.0f, 50.0f, 10.0f };
+
+	for (int i = 1; i < argc; ++i) {
+		auto has_values = [&](int count) {
+			if (i + count >= argc) {
+				std::cerr << "[ERROR] " << argv[i] << " expects " << count << " value(s)" << std::endl;
+				return false;
+			}
+
+			return true;
+		};
+
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+			print_usage();
+			return 0;
+		} else if (!strcmp(argv[i], "--pattern")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.pattern = argv[++i];
+		} else if (!strcmp(argv[i], "--lines")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.lines = strtoull(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "--seed")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		} else if (!strcmp(argv[i], "--tool")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.tool = argv[++i];
+		} else if (!strcmp(argv[i], "--size")) {
+			if (!has_values(3)) {
+				return 1;
+			}
+
+			settings.size_x = static_cast<float>(atof(argv[++i])) * 10.0f;
+			settings.height = static_cast<float>(atof(argv[++i])) * 10.0f;
+			settings.size_y = static_cast<float>(atof(argv[++i])) * 10.0f;
+		} else if (!strcmp(argv[i], "--min-height")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.min_height = static_cast<float>(atof(argv[++i])) * 10.0f;
+		} else if (!strcmp(argv[i], "--output")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			settings.output = argv[++i];
+		} else {
+			std::cerr << "[ERROR] unexpected argument " << argv[i] << std::endl;
+			print_usage();
+			return 1;
+		}
+	}
+
+	const auto& tool = settings.tool;
+
+	if (tool.size() != 3 || (tool[0] != 'k' && tool[0] != 'f') || !isdigit(tool[1]) || !isdigit(tool[2])) {
+		std::cerr << "[ERROR] invalid tool '" << tool << "', please use kXX or fXX" << std::endl;
+		return 1;
+	}
+
+	if (settings.lines == 0 || settings.size_x <= 0.0f || settings.size_y <= 0.0f || settings.height <= 0.0f) {
+		std::cerr << "[ERROR] line count and block size have to be positive" << std::endl;
+		return 1;
+	}
+
+	if (settings.min_height < 0.0f || settings.min_height >= settings.height) {
+		std::cerr << "[ERROR] minimum height has to lie between the bottom and the top of the block" << std::endl;
+		return 1;
+	}
+
+	const std::string path = settings.output + "." + tool;
+	program_writer_t writer(path);
+
+	if (!writer.is_open()) {
+		std::cerr << "[ERROR] failed to open " << path << std::endl;
+		return 1;
+	}
+
+	if (settings.pattern == "raster") {
+		write_raster(settings, writer);
+	} else if (settings.pattern == "spiral") {
+		write_spiral(settings, writer);
+	} else if (settings.pattern == "plunge") {
+		write_plunge(settings, writer);
+	} else if (settings.pattern == "finish") {
+		write_finish(settings, writer);
+	} else {
+		std::cerr << "[ERROR] unknown pattern " << settings.pattern << std::endl;
+		return 1;
+	}
+
+	// lift the cutter and bring it back over the center, like the bundled programs end
+	writer.lift(safe_height(settings));
+	writer.move(0.0f, 0.0f, safe_height(settings));
+
+	uint64_t lines = writer.get_lines();
+
+	if (!writer.close()) {
+		std::cerr << "[ERROR] failed to write " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << "[INFO] wrote " << lines << " commands of the " << settings.pattern << " pattern to " << path << std::endl;
+	return 0;
+}
@@ -0,0 +1,322 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "block.hpp"
+#include "cutter.hpp"
+#include "memory.hpp"
+#include "toolpath.hpp"
+#include "trace.hpp"
+
+// simulates a milling program without opening a window and writes out the carved heightmap
+// and the errors the cutter ran into
+
+static void print_usage() {
+	std::cout <<
+		"usage: millsim <path> [options]\n"
+		"  --tool <kXX|fXX>       cutter, ball or flat end with a diameter in millimetres,\n"
+		"                         read from the path extension when not given\n"
+		"  --size <x> <y> <z>     block size in centimetres, 18 5 18 by default\n"
+		"  --resolution <w> <h>   heightmap texels along x and z, 1200 1200 by default\n"
+		"  --min-height <h>       lowest height the cutter may go down to, 1 by default\n"
+		"  --blade-height <h>     height of the cutting part of the cutter, 3 by default\n"
+		"  --quantized            store heights in 16 bits instead of floats\n"
+		"  --stream               start carving while the program is still being parsed\n"
+		"  --cache                read the points from the cache next to the program when it\n"
+		"                         still matches, and write the cache when it does not\n"
+		"  --output <file>        heightmap, row-major 32 bit floats in centimetres above the\n"
+		"                         bottom of the block, heights.raw by default\n"
+		"  --report <file>        errors as '<kind> <segment>' lines, errors.txt by default\n"
+		"  --segment-stats <file> counts the texels every segment lowered and writes\n"
+		"                         '<segment> <stamps> <texels> <lowered>' lines, slows carving down\n"
+		"  --trace <file>         chrome trace of loading and milling, for Perfetto\n"
+		"  --memory               lists the memory every subsystem keeps once milling is done\n";
+}
+
+static const char* error_name(uint32_t type) {
+	switch (type) {
+		case mini::MILLING_ERROR_COLLISION: return "collision";
+		case mini::MILLING_ERROR_DEPTH: return "depth";
+		case mini::MILLING_ERROR_FLAT: return "flat";
+		default: return "unknown";
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string path, tool, trace_path, segment_stats_path;
+	std::string output = "heights.raw";
+	std::string report = "errors.txt";
+
+	glm::vec3 size = { 18.0f, 5.0f, 18.0f };
+	int resolution_x = 1200, resolution_y = 1200;
+	float min_height = 1.0f;
+	float blade_height = 3.0f;
+	bool quantized = false;
+	bool memory = false;
+	bool streamed = false;
+	bool cached = false;
+
+	for (int i = 1; i < argc; ++i) {
+		auto has_values = [&](int count) {
+			if (i + count >= argc) {
+				std::cerr << "[ERROR] " << argv[i] << " expects " << count << " value(s)" << std::endl;
+				return false;
+			}
+
+			return true;
+		};
+
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+			print_usage();
+			return 0;
+		} else if (!strcmp(argv[i], "--tool")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			tool = argv[++i];
+		} else if (!strcmp(argv[i], "--size")) {
+			if (!has_values(3)) {
+				return 1;
+			}
+
+			size.x = static_cast<float>(atof(argv[++i]));
+			size.y = static_cast<float>(atof(argv[++i]));
+			size.z = static_cast<float>(atof(argv[++i]));
+		} else if (!strcmp(argv[i], "--resolution")) {
+			if (!has_values(2)) {
+				return 1;
+			}
+
+			resolution_x = atoi(argv[++i]);
+			resolution_y = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--min-height")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			min_height = static_cast<float>(atof(argv[++i]));
+		} else if (!strcmp(argv[i], "--blade-height")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			blade_height = static_cast<float>(atof(argv[++i]));
+		} else if (!strcmp(argv[i], "--quantized")) {
+			quantized = true;
+		} else if (!strcmp(argv[i], "--memory")) {
+			memory = true;
+		} else if (!strcmp(argv[i], "--stream")) {
+			streamed = true;
+		} else if (!strcmp(argv[i], "--cache")) {
+			cached = true;
+		} else if (!strcmp(argv[i], "--output")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			output = argv[++i];
+		} else if (!strcmp(argv[i], "--report")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			report = argv[++i];
+		} else if (!strcmp(argv[i], "--trace")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			trace_path = argv[++i];
+		} else if (!strcmp(argv[i], "--segment-stats")) {
+			if (!has_values(1)) {
+				return 1;
+			}
+
+			segment_stats_path = argv[++i];
+		} else if (argv[i][0] == '-' || !path.empty()) {
+			std::cerr << "[ERROR] unexpected argument " << argv[i] << std::endl;
+			print_usage();
+			return 1;
+		} else {
+			path = argv[i];
+		}
+	}
+
+	if (path.empty()) {
+		print_usage();
+		return 1;
+	}
+
+	if (streamed && cached) {
+		std::cerr << "[ERROR] --stream and --cache cannot be used together" << std::endl;
+		return 1;
+	}
+
+	if (size.x <= 0.0f || size.y <= 0.0f || size.z <= 0.0f || resolution_x <= 0 || resolution_y <= 0) {
+		std::cerr << "[ERROR] block size and resolution have to be positive" << std::endl;
+		return 1;
+	}
+
+	auto& recorder = mini::trace_recorder::get();
+	recorder.set_thread_name("main");
+
+	if (!trace_path.empty()) {
+		recorder.start();
+	}
+
+	mini::milling_block block(resolution_x, resolution_y, min_height / size.y, quantized);
+	block.set_block_size(size);
+	block.set_count_writes(!segment_stats_path.empty());
+
+	std::unique_ptr<mini::milling_cutter> cutter;
+	std::size_t point_count = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	if (streamed) {
+		// the time includes parsing, which runs alongside carving
+		auto stream = tool.empty() ? mini::stream_toolpath(path) : mini::stream_toolpath(path, tool);
+
+		if (!stream) {
+			return 1;
+		}
+
+		// the cutter shares the path and carves whatever was added to it since the last call
+		auto toolpath = std::make_shared<mini::toolpath>(stream->get_radius(), stream->is_spherical());
+		cutter = std::make_unique<mini::milling_cutter>(toolpath, blade_height, block);
+
+		bool first_cut = true;
+
+		while (true) {
+			// asked before taking, so no point pushed in between is left behind
+			bool finished = stream->is_finished();
+
+			if (stream->take_points(*toolpath) > 0) {
+				point_count = toolpath->get_point_count();
+				cutter->instant(block);
+
+				if (first_cut && point_count >= 2) {
+					std::chrono::duration<double> first = std::chrono::steady_clock::now() - start;
+					std::cout << "[INFO] first segment carved after " << first.count() << " s" << std::endl;
+					first_cut = false;
+				}
+			} else if (finished) {
+				break;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	} else {
+		auto load_start = std::chrono::steady_clock::now();
+		std::shared_ptr<mini::toolpath> toolpath;
+
+		if (cached) {
+			toolpath = tool.empty() ? mini::load_toolpath_cached(path) : mini::load_toolpath_cached(path, tool);
+		} else {
+			toolpath = tool.empty() ? mini::load_toolpath(path) : mini::load_toolpath(path, tool);
+		}
+
+		std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
+		std::cout << "[INFO] loaded the program in " << load_time.count() << " s" << std::endl;
+
+		if (!toolpath) {
+			return 1;
+		}
+
+		point_count = toolpath->get_point_count();
+
+		if (point_count >= 2) {
+			cutter = std::make_unique<mini::milling_cutter>(toolpath, blade_height, block);
+
+			start = std::chrono::steady_clock::now();
+			cutter->instant(block);
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	if (point_count < 2) {
+		std::cerr << "[ERROR] " << path << " holds no path segments" << std::endl;
+		return 1;
+	}
+
+	if (!trace_path.empty()) {
+		recorder.stop();
+
+		if (!recorder.write(trace_path)) {
+			return 1;
+		}
+	}
+
+	std::cout << "[INFO] milled " << point_count - 1 << " segments in " << elapsed.count() << " s" << std::endl;
+
+	if (memory) {
+		const auto& registry = mini::memory_registry::get();
+		std::vector<mini::memory_registry::usage_t> usage;
+		registry.get_usage(usage);
+
+		for (const auto& entry : usage) {
+			std::cout << "[INFO] memory " << entry.name << ": " << entry.host_bytes << " bytes in " << entry.owners
+				<< " owner(s)" << std::endl;
+		}
+
+		std::cout << "[INFO] memory total: " << registry.get_host_bytes() << " bytes, "
+			<< registry.get_peak_host_bytes() << " bytes at the peak" << std::endl;
+	}
+
+	std::vector<float> heights;
+	block.read_heights(heights);
+
+	for (auto& height : heights) {
+		height *= size.y;
+	}
+
+	std::ofstream heights_file(output, std::ios::binary);
+	heights_file.write(reinterpret_cast<const char*>(heights.data()), heights.size() * sizeof(float));
+
+	if (!heights_file) {
+		std::cerr << "[ERROR] failed to write " << output << std::endl;
+		return 1;
+	}
+
+	std::ofstream report_file(report);
+
+	for (const auto& error : cutter->get_errors()) {
+		report_file << error_name(error.type) << " " << error.segment << "\n";
+	}
+
+	if (!report_file) {
+		std::cerr << "[ERROR] failed to write " << report << std::endl;
+		return 1;
+	}
+
+	std::cout << "[INFO] wrote " << resolution_x << "x" << resolution_y << " heights to " << output << " and "
+		<< cutter->get_errors().size() << " errors to " << report << std::endl;
+
+	if (!segment_stats_path.empty()) {
+		std::ofstream stats_file(segment_stats_path);
+		const auto& segments = block.get_segment_stats();
+
+		for (std::size_t segment = 0; segment < segments.size(); ++segment) {
+			stats_file << segment << " " << segments[segment].stamps << " " << segments[segment].texels << " "
+				<< segments[segment].lowered << "\n";
+		}
+
+		if (!stats_file) {
+			std::cerr << "[ERROR] failed to write " << segment_stats_path << std::endl;
+			return 1;
+		}
+
+		const auto stats = block.get_carve_stats();
+		double noop = stats.texels > 0 ? 1.0 - static_cast<double>(stats.lowered) / stats.texels : 0.0;
+
+		std::cout << "[INFO] wrote the counters of " << segments.size() << " segments to " << segment_stats_path
+			<< ", " << noop * 100.0 << "% of the texels visited were left as they were" << std::endl;
+	}
+
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include "shader.hpp"
+#include "trace.hpp"
 
 #include <cstring>
 #include <glm/gtc/type_ptr.hpp>
@@ -246,6 +247,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform_sampler (const std::string & name, const GLint value) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -254,6 +256,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform_int (const std::string & name, const GLint value) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -262,6 +265,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform_uint (const std::string & name, const GLuint value) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -270,6 +274,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const float value) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -278,6 +283,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const glm::vec2 & vector) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -286,6 +292,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const glm::vec3 & vector) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -294,6 +301,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const glm::vec4 & vector) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -302,6 +310,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const glm::mat3x3 & matrix) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -310,6 +319,7 @@ namespace mini {
 	}
 
 	void shader_program::set_uniform (const std::string & name, const glm::mat4x4 & matrix) {
+		MINI_TRACE_ZONE ("shader_program::set_uniform");
 		const int location = get_uniform_location (name);
 
 		if (location >= 0) {
@@ -0,0 +1,95 @@
+#include "timer.hpp"
+
+namespace mini {
+	const std::vector<gpu_timer::result_t>& gpu_timer::get_results() const {
+		return m_results;
+	}
+
+	uint64_t gpu_timer::get_dropped_frames() const {
+		return m_dropped;
+	}
+
+	bool gpu_timer::begin_frame() {
+		// queries can only be made once there is a context, which the timer may be created before
+		if (!m_initialized) {
+			for (auto& frame : m_frames) {
+				glGenQueries(GPU_TIMER_QUERIES, frame.queries.data());
+			}
+
+			m_initialized = true;
+		}
+
+		if (m_running) {
+			end();
+		}
+
+		m_current = (m_current + 1) % GPU_TIMER_FRAMES;
+		auto& frame = m_frames[m_current];
+
+		if (frame.scopes.empty()) {
+			return false;
+		}
+
+		// the queries of a frame finish in order, so the last one being ready covers all of them
+		GLint available = 0;
+		glGetQueryObjectiv(frame.queries[frame.scopes.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available) {
+			m_dropped++;
+			frame.scopes.clear();
+			return false;
+		}
+
+		m_results.clear();
+
+		for (std::size_t i = 0; i < frame.scopes.size(); ++i) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+
+			m_results.push_back({ frame.scopes[i].name, frame.scopes[i].group, static_cast<float>(elapsed / 1e6) });
+		}
+
+		frame.scopes.clear();
+		return true;
+	}
+
+	void gpu_timer::begin(const char* name, uint32_t group) {
+		auto& frame = m_frames[m_current];
+
+		if (!m_initialized || m_running || frame.scopes.size() >= GPU_TIMER_QUERIES) {
+			return;
+		}
+
+		glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.scopes.size()]);
+		frame.scopes.push_back({ name, group });
+		m_running = true;
+	}
+
+	void gpu_timer::end() {
+		if (!m_running) {
+			return;
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		m_running = false;
+	}
+
+	gpu_timer::gpu_timer() :
+		m_current(0),
+		m_initialized(false),
+		m_running(false),
+		m_dropped(0) {
+
+		for (auto& frame : m_frames) {
+			frame.queries.fill(0);
+		}
+	}
+
+	gpu_timer::~gpu_timer() {
+		if (m_initialized) {
+			for (auto& frame : m_frames) {
+				glDeleteQueries(GPU_TIMER_QUERIES, frame.queries.data());
+			}
+		}
+	}
+}
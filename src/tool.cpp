@@ -0,0 +1,40 @@
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "tool.hpp"
+
+namespace mini {
+	milling_cutter_model::milling_cutter_model(std::shared_ptr<shader_program> shader, float blade_height) {
+		m_shader = shader;
+		m_blade_height = blade_height;
+		m_mesh = triangle_mesh::make_cylinder(1.0f, 10.0f, 100, 100);
+	}
+
+	milling_cutter_model::~milling_cutter_model() { }
+
+	void milling_cutter_model::render(app_context& context, const glm::mat4x4& world_matrix) const {
+		auto& shader = *m_shader.get();
+
+		const auto& view_matrix = context.get_view_matrix();
+		const auto& proj_matrix = context.get_projection_matrix();
+
+		const auto blade_offset = glm::translate(glm::mat4x4(1.0f), { 0.0f, -m_blade_height, 0.0f });
+		const auto blade_scale = glm::scale(glm::mat4x4(1.0f), { 1.0f, 1.0f, m_blade_height / 10.0f });
+
+		shader.bind();
+
+		context.set_lights(shader);
+		shader.set_uniform("u_surface_color", glm::vec3{ 1.0f, 0.2f, 0.0f });
+		shader.set_uniform("u_shininess", 1.0f);
+
+		shader.set_uniform("u_world", world_matrix * blade_scale);
+		shader.set_uniform("u_view", view_matrix);
+		shader.set_uniform("u_projection", proj_matrix);
+
+		m_mesh->draw();
+
+		shader.set_uniform("u_surface_color", glm::vec3{ 0.81f, 0.35f, 0.77f });
+		shader.set_uniform("u_world", blade_offset * world_matrix);
+
+		m_mesh->draw();
+	}
+}
\ No newline at end of file
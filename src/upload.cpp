@@ -0,0 +1,191 @@
+#include "upload.hpp"
+#include "memory.hpp"
+#include <cstring>
+#include <iostream>
+
+namespace mini {
+	bool pixel_upload_ring::is_persistent() const {
+		return m_persistent;
+	}
+
+	void pixel_upload_ring::upload(
+		GLint x,
+		GLint y,
+		GLsizei width,
+		GLsizei height,
+		GLenum format,
+		GLenum type,
+		std::size_t texel_size,
+		const void* data,
+		std::size_t row_stride) {
+
+		// rows are packed tightly and start on a four byte boundary, as the default unpack alignment expects
+		std::size_t packed_row = (width * texel_size + 3) & ~static_cast<std::size_t>(3);
+		std::size_t size = packed_row * height;
+
+		if (m_acquired && m_segments[m_current].used + size > m_segment_size) {
+			flush();
+		}
+
+		if (size > m_segment_size || !m_acquire()) {
+			// anything staged earlier has to land first, it may cover the same texels
+			flush();
+
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(row_stride / texel_size));
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, data);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			return;
+		}
+
+		auto& segment = m_segments[m_current];
+		uint8_t* dst = m_segment_data() + segment.used;
+		const uint8_t* src = static_cast<const uint8_t*>(data);
+
+		for (GLsizei row = 0; row < height; ++row) {
+			std::memcpy(dst + row * packed_row, src + row * row_stride, width * texel_size);
+		}
+
+		m_pending.push_back({ x, y, width, height, format, type, m_current * m_segment_size + segment.used });
+		segment.used += size;
+	}
+
+	void pixel_upload_ring::flush() {
+		if (!m_acquired) {
+			return;
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+
+		if (!m_persistent) {
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			m_mapped = nullptr;
+		}
+
+		for (const auto& pending : m_pending) {
+			glTexSubImage2D(
+				GL_TEXTURE_2D,
+				0,
+				pending.x,
+				pending.y,
+				pending.width,
+				pending.height,
+				pending.format,
+				pending.type,
+				reinterpret_cast<const void*>(pending.offset));
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		m_segments[m_current].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_current = (m_current + 1) % m_segments.size();
+		m_acquired = false;
+		m_pending.clear();
+	}
+
+	bool pixel_upload_ring::m_acquire() {
+		if (m_acquired) {
+			return true;
+		}
+
+		auto& segment = m_segments[m_current];
+
+		if (segment.fence) {
+			// a zero timeout only polls, a segment still in flight is skipped instead of waited for
+			GLenum status = glClientWaitSync(segment.fence, 0, 0);
+
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+				return false;
+			}
+
+			glDeleteSync(segment.fence);
+			segment.fence = nullptr;
+		}
+
+		if (!m_persistent) {
+			// the fence guarantees the gpu is done with this range, no need for the driver to sync
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+			m_mapped = static_cast<uint8_t*>(glMapBufferRange(
+				GL_PIXEL_UNPACK_BUFFER,
+				m_current * m_segment_size,
+				m_segment_size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (!m_mapped) {
+				return false;
+			}
+		}
+
+		segment.used = 0;
+		m_acquired = true;
+
+		return true;
+	}
+
+	uint8_t* pixel_upload_ring::m_segment_data() {
+		// a persistent mapping covers the whole buffer, otherwise only the current segment is mapped
+		return m_persistent ? m_mapped + m_current * m_segment_size : m_mapped;
+	}
+
+	pixel_upload_ring::pixel_upload_ring(std::size_t segment_size, uint32_t segment_count) :
+		m_buffer(0),
+		m_mapped(nullptr),
+		m_persistent(false),
+		m_segment_size(segment_size),
+		m_segments(segment_count, { nullptr, 0 }),
+		m_current(0),
+		m_acquired(false) {
+
+		std::size_t buffer_size = segment_size * segment_count;
+
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+
+		if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, buffer_size, nullptr, flags);
+			m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, buffer_size, flags));
+			m_persistent = m_mapped != nullptr;
+
+			if (!m_persistent) {
+				std::cerr << "[WARN] persistent mapping of the upload ring failed" << std::endl;
+			}
+		}
+
+		if (!m_persistent) {
+			// immutable storage cannot be reallocated, start from a fresh buffer
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &m_buffer);
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer_size, nullptr, GL_STREAM_DRAW);
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		memory_registry::get().report(this, "upload ring", 0, buffer_size);
+	}
+
+	pixel_upload_ring::~pixel_upload_ring() {
+		flush();
+		memory_registry::get().release(this);
+
+		for (auto& segment : m_segments) {
+			if (segment.fence) {
+				glDeleteSync(segment.fence);
+			}
+		}
+
+		if (m_buffer) {
+			if (m_persistent) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+
+			glDeleteBuffers(1, &m_buffer);
+		}
+	}
+}
@@ -2,12 +2,14 @@
 #include <iostream>
 
 #include "window.hpp"
+#include "trace.hpp"
 
 // use imgui library
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
+#include <implot.h>
 
 namespace mini {
 	void GLAPIENTRY gl_error_callback (GLenum source, GLenum type, GLuint id,
@@ -61,6 +63,22 @@ namespace mini {
 		return (iter != m_pressed_keys.end ());
 	}
 
+	frame_profiler & app_window::get_profiler () {
+		return m_profiler;
+	}
+
+	const frame_profiler & app_window::get_profiler () const {
+		return m_profiler;
+	}
+
+	gpu_timer & app_window::get_gpu_timer () {
+		return m_gpu_timer;
+	}
+
+	const gpu_timer & app_window::get_gpu_timer () const {
+		return m_gpu_timer;
+	}
+
 	void app_window::set_width (uint32_t width) {
 		m_width = width;
 		glfwSetWindowSize (m_window.get (), m_width, m_height);
@@ -128,12 +146,24 @@ namespace mini {
 		m_setup_imgui ();
 	}
 
-	app_window::~app_window () { }
+	app_window::~app_window () {
+		ImPlot::DestroyContext ();
+	}
 
 	void app_window::message_loop () {
 		m_last_frame = std::chrono::steady_clock::now();
 
 		while (!glfwWindowShouldClose (m_window.get ())) {
+			MINI_TRACE_ZONE ("app_window::frame");
+			m_profiler.begin_frame ();
+
+			// gpu times arrive a few frames late and are booked to the frame that reads them back
+			if (m_gpu_timer.begin_frame ()) {
+				for (const auto & result : m_gpu_timer.get_results ()) {
+					m_profiler.add (result.group, result.milliseconds);
+				}
+			}
+
 			glfwPollEvents ();
 
 			// calculate delta time
@@ -153,10 +183,15 @@ namespace mini {
 			t_integrate (elapsed);
 			t_render ();
 
+			m_profiler.begin (PROFILER_GUI);
 			ImGui::Render ();
+			m_gpu_timer.begin ("imgui", PROFILER_GPU_GUI);
 			ImGui_ImplOpenGL3_RenderDrawData (ImGui::GetDrawData ());
+			m_gpu_timer.end ();
+			m_profiler.end (PROFILER_GUI);
 
 			glfwSwapBuffers (m_window.get ());
+			m_profiler.end_frame ();
 		}
 	}
 
@@ -232,6 +267,7 @@ namespace mini {
 		ImGui::DebugCheckVersionAndDataLayout (IMGUI_VERSION, sizeof (ImGuiIO), sizeof (ImGuiStyle), sizeof (ImVec2), sizeof (ImVec4), sizeof (ImDrawVert), sizeof (ImDrawIdx));
 
 		ImGui::CreateContext ();
+		ImPlot::CreateContext ();
 		ImGuiIO & io = ImGui::GetIO (); (void)io;
 
 		// dont generate ini file